@@ -6,23 +6,27 @@
  * documentation. 
  */
 
+#include <algorithm>
+#include <climits>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <string>
 #include <vector>
 #include <stack>
-#include <climits>
-#include <queue>
 #include <unordered_map>
 #include "actorgraph.hpp"
+#include "memory.hpp"
+#include "trace.hpp"
+#include "traversal.hpp"
 
 using namespace std;
 
 
 /*
  * ActorGraph loadFromFile creates all graph data structures from tab delimited 
- * actor, movie relationships. Initializes actor_map, movie_map, and vertices.
+ * actor, movie relationships. Initializes actor and movie ids and adjacency
+ * arrays.
  *
  * Parameters: 
  *  in_filename - 
@@ -33,13 +37,17 @@ using namespace std;
  *      If true, all edge weights will be equal to (2018 - Y) + 1,
  *      prioritizing newer movies in Dijkstra's algorithm. Otherwise, all 
  *      movies will be equally weighted.
+ *  from_year, to_year -
+ *      Only movies of these years or between are loaded, with their actors.
  *
  * Returns: 
  *  bool -
  *      True indicates successful reading of file.  
  */
 bool ActorGraph::loadFromFile(const char *in_filename,
-                              const bool use_weighted_edges) {
+                              const bool use_weighted_edges,
+                              int from_year, int to_year) {
+    TRACE_SCOPE("load");
     // Initialize the file stream
     ifstream infile(in_filename);
     if (!infile) 
@@ -49,7 +57,11 @@ bool ActorGraph::loadFromFile(const char *in_filename,
     string s;
     getline(infile, s);
 
-    // Parse file, building data structures
+    // Actor and movie of each row, actors numbered by first appearance
+    vector<pair<int, int>> rows;
+    unordered_map<string, int> movie_ids;
+
+    // Parse file, numbering actors and movies
     while (getline(infile, s)) {
 
         // Parse the line by tabs 
@@ -64,28 +76,30 @@ bool ActorGraph::loadFromFile(const char *in_filename,
             return false;
         }
         
-        string actor_name(record[0]);
+        string& actor_name = record[0];
         string movie_title(record[1].append("#@").append(record[2]));
         int movie_year = stoi(record[2]); 
+        if (movie_year < from_year || movie_year > to_year)
+            continue;
         
-        // Add movie to the actor 
-        if (actor_map.find(actor_name) == actor_map.end()) { 
-            actor_map[actor_name] = vector<string>();
+        // Number the actor
+        auto actor = actor_ids.find(actor_name);
+        if (actor == actor_ids.end()) {
+            actor = actor_ids.emplace(actor_name, actor_names.size()).first;
+            actor_names.push_back(actor_name);
         }
-        actor_map[actor_name].push_back(movie_title);
         
-        // Add actor to the movie
-        if (movie_map.find(movie_title) == movie_map.end()) { 
-            movie_map[movie_title] = pair<int, vector<string>>
-                (use_weighted_edges ? (2018 - movie_year + 1) : 1,
-                vector<string>());
+        // Number the movie
+        auto movie = movie_ids.find(movie_title);
+        if (movie == movie_ids.end()) {
+            movie = movie_ids.emplace(movie_title, movie_titles.size()).first;
+            movie_titles.push_back(movie_title);
+            movie_years.push_back(movie_year);
+            movie_weights.push_back(
+                use_weighted_edges ? (2018 - movie_year + 1) : 1);
         }
-        movie_map[movie_title].second.push_back(actor_name);
-    }
 
-    // Initialize empty Vertex for all actors, for use in Dijkstra's algorithm
-    for (auto p : actor_map) { 
-        vertices[p.first] = new Vertex(p.first);
+        rows.push_back(pair<int, int>(actor->second, movie->second));
     }
     
     if (!infile.eof()) {
@@ -93,6 +107,61 @@ bool ActorGraph::loadFromFile(const char *in_filename,
     }
     infile.close();
 
+    // Renumber actors in order of name, so ids compare as names do
+    TRACE_BEGIN("load renumber");
+    int num_actors = (int)actor_names.size();
+    vector<int> order(num_actors);
+    for (int i = 0; i < num_actors; i++)
+        order[i] = i;
+    sort(order.begin(), order.end(), [this](int x, int y) {
+        return actor_names[x] < actor_names[y];
+    });
+    vector<int> rename(num_actors);
+    vector<string> sorted_names(num_actors);
+    for (int i = 0; i < num_actors; i++) {
+        rename[order[i]] = i;
+        sorted_names[i].swap(actor_names[order[i]]);
+    }
+    actor_names.swap(sorted_names);
+    for (auto& p : actor_ids)
+        p.second = rename[p.second];
+
+    TRACE_END("load renumber");
+
+    // Build both adjacency arrays by counting, keeping file order
+    TRACE_BEGIN("load adjacency");
+    int num_movies = (int)movie_titles.size();
+    actor_offsets.assign(num_actors + 1, 0);
+    movie_offsets.assign(num_movies + 1, 0);
+    for (auto& row : rows) {
+        row.first = rename[row.first];
+        actor_offsets[row.first + 1]++;
+        movie_offsets[row.second + 1]++;
+    }
+    for (int i = 0; i < num_actors; i++)
+        actor_offsets[i + 1] += actor_offsets[i];
+    for (int i = 0; i < num_movies; i++)
+        movie_offsets[i + 1] += movie_offsets[i];
+
+    actor_movies.resize(rows.size());
+    movie_actors.resize(rows.size());
+    vector<int> actor_fill(actor_offsets.begin(), actor_offsets.end() - 1);
+    vector<int> movie_fill(movie_offsets.begin(), movie_offsets.end() - 1);
+    for (auto& row : rows) {
+        actor_movies[actor_fill[row.first]++] = row.second;
+        movie_actors[movie_fill[row.second]++] = row.first;
+    }
+
+    // Record the span of years each actor was active
+    actor_first_years.assign(num_actors, INT_MAX);
+    actor_last_years.assign(num_actors, INT_MIN);
+    for (auto& row : rows) {
+        int year = movie_years[row.second];
+        actor_first_years[row.first] = min(actor_first_years[row.first], year);
+        actor_last_years[row.first] = max(actor_last_years[row.first], year);
+    }
+    TRACE_END("load adjacency");
+
     return true;
 }
 
@@ -100,108 +169,124 @@ bool ActorGraph::loadFromFile(const char *in_filename,
 /* 
  * ActorGraph findPath uses Dijkstra's algorithm to find the shortest path
  * between two actors using mutual movies as edges, and writes this shortest
- * path to a specified file. 
+ * path to a specified stream. Nothing is written if either actor is unknown.
  * 
  * Parameters: 
- *  ofstream & out_file - 
- *      File to write the shortest path to. File will remain open after call.
+ *  ostream & out_file - 
+ *      Stream to write the shortest path to. Remains open after call.
  *  string start_name - 
  *      The starting actor of the path.
  *  string end_name - 
  *      The ending actor of the path. 
  */ 
-void ActorGraph::findPath(ofstream& out_file, 
+void ActorGraph::findPath(ostream& out_file, 
     string start_name, string end_name) {
 
-    // Min-heap for Dijkstra algorithm, weighted by lowest distance
-    priority_queue<Vertex *, vector<Vertex *>, vertexComp> pq; 
-
-    // Initialize all Vertices of graph
-    for (auto v : vertices) { 
-        v.second->dist = INT_MAX; 
-        v.second->done = false;
-        v.second->prev_actor = ""; 
-        v.second->prev_movie = ""; 
-    }
+    SearchState state(*this);
+    findPath(out_file, actorId(start_name), actorId(end_name), state);
+}
 
-    // Add starting vertex to pq
-    Vertex* working = vertices[start_name]; 
-    working->dist = 0; 
-    pq.push(working); 
 
-    // Represents weight of current movie
-    int weight; 
+/* 
+ * Same as findPath above for actor ids, reusing the labels in state between
+ * calls. Safe to call concurrently with distinct states. Nothing is written
+ * if no path exists.
+ *
+ * Parameters:
+ *  ostream & out_file -
+ *      Stream to write the shortest path to.
+ *  int start -
+ *      Id of the starting actor of the path.
+ *  int end -
+ *      Id of the ending actor of the path.
+ *  SearchState & state -
+ *      Labels sized for this graph, reset before the search.
+ *  const Exclusions * avoid -
+ *      Actors and movies the path may not pass through, or null.
+ */
+void ActorGraph::findPath(ostream& out_file, int start, int end,
+                          SearchState& state,
+                          const Exclusions* avoid) const {
+    if (start < 0 || end < 0)
+        return;
+    if (avoid && (avoid->hasActor(start) || avoid->hasActor(end)))
+        return;
 
-    // Explore working vertex, adding adjacent to pq following Dijkstra's
-    while (pq.size()) { 
-        working = pq.top(); 
-        pq.pop();
+    // Min-heap for Dijkstra algorithm, weighted by lowest distance
+    state.reset();
+    HeapFrontier<> pq(state);
+    addSource(state, pq, start);
 
-        // Stop if ending vertex being explored 
-        if (working->name == end_name)
-            break;
+    // Explore from start until the ending vertex leaves the heap
+    int working;
+    if (avoid) {
+        AvoidingVisitor<TargetVisitor> visitor(avoid, TargetVisitor(end));
+        working = traverse(*this, state, pq, MovieWeight(), visitor);
+    } else {
+        TargetVisitor visitor(end);
+        working = traverse(*this, state, pq, MovieWeight(), visitor);
+    }
+    if (working != end)
+        return;
+    writePath(out_file, state, working);
+}
 
-        // Continue if vertex has already been explored
-        if (working->done) 
-            continue;
 
-        working->done = true; 
-
-        // Explore working's neighbors, by movie
-        for (string movie : actor_map[working->name]) { 
-            // Set weight of edge
-            weight = movie_map[movie].first;
-            for (string adj_actor : movie_map[movie].second) { 
-                // Skip current actor 
-                if (adj_actor == working->name) 
-                    continue;
-                // If distance through working less than previous best distance,
-                // change the previous to working and push to pq
-                if (working->dist + weight < vertices[adj_actor]->dist) { 
-                    vertices[adj_actor]->prev_actor = working->name; 
-                    vertices[adj_actor]->prev_movie = movie; 
-                    vertices[adj_actor]->dist = working->dist + weight; 
-                    pq.push(vertices[adj_actor]);
-                }
-            }
-        }
-    }
+/* 
+ * Writes the path a search labelled from its source to actor last, in the
+ * format of findPath.
+ *
+ * Parameters: 
+ *  ostream & out_file -
+ *      Stream to write the path to.
+ *  const SearchState & state -
+ *      Labels of a finished search.
+ *  int last -
+ *      Actor the path ends at.
+ */
+void ActorGraph::writePath(ostream& out_file, const SearchState& state,
+                           int last) const {
+    int working = last;
 
     // Reverse the order from end to start using a stack  
-    stack<string> vs; 
-    while (working->prev_actor != "") { 
-        vs.push(working->name);
-        vs.push(working->prev_movie);
-        working = vertices[working->prev_actor];
+    stack<int> vs; 
+    while (state.prev_actor[working] != -1) {
+        vs.push(working);
+        vs.push(state.prev_movie[working]);
+        working = state.prev_actor[working];
     }
-    vs.push(working->name);
+    vs.push(working);
 
     // Write to file from start to end with formatting 
     while (vs.size() > 1) { 
-        out_file << "(" << vs.top() << ")--["; 
+        out_file << "(" << actor_names[vs.top()] << ")--["; 
         vs.pop();
-        out_file << vs.top() << "]-->"; 
+        out_file << movie_titles[vs.top()] << "]-->"; 
         vs.pop();
     }
-    out_file << "(" << vs.top() << ")";
-
-}
-
-
-/* 
- * ActorGraph dctor for dynamically allocated vertices of the graph
- */
-ActorGraph::~ActorGraph() { 
-    for (auto p : vertices) 
-        delete p.second;
+    out_file << "(" << actor_names[vs.top()] << ")";
 }
 
 
-/* 
- * Vertex constructor for graph. Creates Vertex with initialized actor name.
+/*
+ * ActorGraph memoryUsage adds the bytes held by the names, the name index,
+ * the movie attributes and both adjacency arrays to a report. See
+ * memory.hpp.
  *
- * Parameters: 
- *  string n - 
- *      Initializes name of vertex 
+ * Parameters:
+ *  report -
+ *      Report receiving a row per structure.
  */
-ActorGraph::Vertex::Vertex(string n) : name(n) {}
+void ActorGraph::memoryUsage(MemoryReport& report) const {
+    report.add("actor names", memoryBytes(actor_names));
+    report.add("actor ids", memoryBytes(actor_ids));
+    report.add("movie titles", memoryBytes(movie_titles));
+    report.add("movie years and weights",
+               memoryBytes(movie_years) + memoryBytes(movie_weights));
+    report.add("actor years",
+               memoryBytes(actor_first_years) + memoryBytes(actor_last_years));
+    report.add("actor movies",
+               memoryBytes(actor_offsets) + memoryBytes(actor_movies));
+    report.add("movie casts",
+               memoryBytes(movie_offsets) + memoryBytes(movie_actors));
+}
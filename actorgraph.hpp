@@ -4,61 +4,77 @@
  * be called to initialize the ActorGraph prior to using findPath, which prints
  * the shortest path between the actors to a file. See function headers for
  * documentation. 
+ *
+ * Actors and movies are stored under dense integer ids in compressed arrays.
+ * Actor ids are assigned in increasing order of actor name, so comparing two
+ * actor ids is equivalent to comparing their names. The traversal core in
+ * traversal.hpp runs directly over these arrays.
  */
 
 #ifndef ACTORGRAPH_HPP
 #define ACTORGRAPH_HPP
 
+#include <climits>
 #include <iostream>
 #include <vector>
 #include <unordered_map>
 #include <string>
-#include <queue>
 using namespace std; 
 
+// Hints the cache to load address, a no-op on compilers without prefetching.
+#if defined(__GNUC__)
+#define PREFETCH(address) __builtin_prefetch(address)
+#else
+#define PREFETCH(address) ((void)(address))
+#endif
+
+struct SearchState;
+struct Exclusions;
+class MemoryReport;
+
+// Contiguous, read only range of ids stored inside an ActorGraph.
+struct IdRange {
+    const int* first;
+    const int* last;
+
+    const int* begin() const { return first; }
+    const int* end() const { return last; }
+    int size() const { return (int)(last - first); }
+};
+
 class ActorGraph {
 private:
 
-    // Vertex class holds information necessary for Dijkstra's algorithm. 
-    class Vertex { 
-    public: 
-        // Initializes vertex with actor name. 
-        Vertex(string); 
-
-        // Distance from starting vertex.
-        int dist;
-        // Flags vertex visited status. 
-        bool done;
-        // Previous actor and movie to specify which edge was traversed. 
-        string prev_actor;
-        string prev_movie;
-        // Actor name represented by vertex. 
-        const string name; 
-    };
-
-    // Comparator for Vertex class. Sorts STL containers by min distance being
-    // higher priority.
-    struct vertexComp { 
-        bool operator()(Vertex* x, Vertex* y) { 
-            if (x->dist != y->dist) 
-                return x->dist > y->dist; 
-            return x->prev_actor < y->prev_actor; 
-        }
-    };
-
-    // Map from actor name to all movies with that actor.
-    unordered_map<string, vector<string>> actor_map; 
-    // Map from movie name to a pair of movie weight and all actors in movie.
-    unordered_map<string, pair<int, vector<string>>> movie_map; 
-
-    // Map from actor name to Vertex holding information for Dijkstra's.
-    unordered_map<string, Vertex *> vertices; 
+    // Actor names indexed by actor id, in increasing order of name.
+    vector<string> actor_names;
+    // Map from actor name to actor id.
+    unordered_map<string, int> actor_ids;
+
+    // Movie titles, formatted as "title#@year", indexed by movie id.
+    vector<string> movie_titles;
+    // Year and edge weight of each movie, indexed by movie id.
+    vector<int> movie_years;
+    vector<int> movie_weights;
+
+    // Years of the first and last movie of each actor, indexed by actor id.
+    vector<int> actor_first_years;
+    vector<int> actor_last_years;
+
+    // Movies of actor a are actor_movies[actor_offsets[a], actor_offsets[a+1]),
+    // in the order they appear in the input file.
+    vector<int> actor_offsets;
+    vector<int> actor_movies;
+
+    // Actors of movie m are movie_actors[movie_offsets[m], movie_offsets[m+1]),
+    // in the order they appear in the input file.
+    vector<int> movie_offsets;
+    vector<int> movie_actors;
 
 public:
 
     /*
      * Creates all graph data structures from tab delimited actor, movie
-     * relationships. Initializes actor_map, movie_map, and vertices. 
+     * relationships. Initializes actor and movie ids and adjacency arrays.
      *
      * Parameters: 
      *  in_filename - 
@@ -69,32 +85,112 @@ public:
      *      If true, all edge weights will be equal to (2018 - Y) + 1,
      *      prioritizing newer movies in Dijkstra's algorithm. Otherwise, all 
      *      movies will be equally weighted.
+     *  from_year, to_year -
+     *      Only movies of these years or between are loaded, with their
+     *      actors. All by default.
      *
      * Returns: 
      *  bool -
      *      True indicates successful reading of file.  
      */
-    bool loadFromFile(const char *in_filename, const bool use_weighted_edges);
+    bool loadFromFile(const char *in_filename, const bool use_weighted_edges,
+                      int from_year = INT_MIN, int to_year = INT_MAX);
 
     /* 
      * ActorGraph findPath uses Dijkstra's algorithm to find the shortest path
      * between two actors using mutual movies as edges, and writes this shortest
-     * path to a specified file. 
+     * path to a specified stream. Nothing is written if either actor is
+     * unknown.
      * 
      * Parameters: 
-     *  ofstream & out_file - 
-     *      File to write the shortest path to. File will remain open after call.
+     *  ostream & out_file - 
+     *      Stream to write the shortest path to. Remains open after call.
      *  string start_name - 
      *      The starting actor of the path.
      *  string end_name - 
      *      The ending actor of the path. 
      */ 
-    void findPath(ofstream& out_file, string start_name, string end_name);
+    void findPath(ostream& out_file, string start_name, string end_name);
 
     /* 
-     * Deallocates vertices
+     * Same as findPath above for actor ids, reusing the labels in state
+     * between calls. Safe to call concurrently with distinct states. Nothing
+     * is written if no path exists.
+     *
+     * Parameters:
+     *  ostream & out_file -
+     *      Stream to write the shortest path to.
+     *  int start -
+     *      Id of the starting actor of the path.
+     *  int end -
+     *      Id of the ending actor of the path.
+     *  SearchState & state -
+     *      Labels sized for this graph, reset before the search.
+     *  const Exclusions * avoid -
+     *      Actors and movies the path may not pass through, or null.
+     */
+    void findPath(ostream& out_file, int start, int end, SearchState& state,
+                  const Exclusions* avoid = nullptr) const;
+
+    /*
+     * Writes the path a search labelled from its source to actor last, in
+     * the format of findPath.
+     *
+     * Parameters:
+     *  ostream & out_file -
+     *      Stream to write the path to.
+     *  const SearchState & state -
+     *      Labels of a finished search.
+     *  int last -
+     *      Actor the path ends at.
      */
-    ~ActorGraph();
+    void writePath(ostream& out_file, const SearchState& state,
+                   int last) const;
+
+    // Number of distinct actors and movies loaded.
+    int numActors() const { return (int)actor_names.size(); }
+    int numMovies() const { return (int)movie_titles.size(); }
+
+    // Returns the id of the named actor, or -1 if the actor is unknown.
+    int actorId(const string& name) const {
+        auto it = actor_ids.find(name);
+        return it == actor_ids.end() ? -1 : it->second;
+    }
+
+    // Name of an actor and "title#@year" of a movie, by id.
+    const string& actorName(int actor) const { return actor_names[actor]; }
+    const string& movieTitle(int movie) const { return movie_titles[movie]; }
+
+    // Release year and traversal weight of a movie, by id.
+    int movieYear(int movie) const { return movie_years[movie]; }
+    int movieWeight(int movie) const { return movie_weights[movie]; }
+
+    // Years of an actor's first and last movie, by id.
+    int actorFirstYear(int actor) const { return actor_first_years[actor]; }
+    int actorLastYear(int actor) const { return actor_last_years[actor]; }
+
+    // Roles, an actor's appearance in a movie. The roles of actor a are
+    // numbered [firstRole(a), firstRole(a + 1)), in moviesOf(a) order.
+    int numRoles() const { return (int)actor_movies.size(); }
+    int firstRole(int actor) const { return actor_offsets[actor]; }
+
+    // Movies an actor appeared in.
+    IdRange moviesOf(int actor) const {
+        return IdRange{actor_movies.data() + actor_offsets[actor],
+                       actor_movies.data() + actor_offsets[actor + 1]};
+    }
+
+    // Hints the cache to load the cast bounds of a movie, ahead of castOf.
+    void prefetchMovie(int movie) const { PREFETCH(&movie_offsets[movie]); }
+
+    // Actors appearing in a movie.
+    IdRange castOf(int movie) const {
+        return IdRange{movie_actors.data() + movie_offsets[movie],
+                       movie_actors.data() + movie_offsets[movie + 1]};
+    }
+
+    // Adds the bytes held by each structure of the graph to report.
+    void memoryUsage(MemoryReport& report) const;
 };
 
 #endif  // ACTORGRAPH_HPP
@@ -0,0 +1,1644 @@
+/*
+ * This file contains the main function for the analyzer program, which runs
+ * whole graph analyses over the actor network. Use
+ *
+ * make analyzer
+ *
+ * to make the program. Each analysis is a mode, selected by the second
+ * argument. Refer to the README or USAGE for the available modes.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "actorgraph.hpp"
+#include "bicore.hpp"
+#include "butterfly.hpp"
+#include "distancesketch.hpp"
+#include "graphmatrix.hpp"
+#include "hyperanf.hpp"
+#include "memory.hpp"
+#include "neighborsets.hpp"
+#include "options.hpp"
+#include "parallel.hpp"
+#include "pathbatch.hpp"
+#include "pathpipeline.hpp"
+#include "pregel.hpp"
+#include "queryplanner.hpp"
+#include "rankindex.hpp"
+#include "sparsematrix.hpp"
+#include "sparsify.hpp"
+#include "spectral.hpp"
+#include "trace.hpp"
+#include "traversal.hpp"
+#include "tuning.hpp"
+
+using namespace std;
+
+// Usage string
+const static string USAGE =
+    "./analyzer called with incorrect arguments.\n"
+    "Usage: ./analyzer data.tsv mode output [mode arguments]\n"
+    "\tlabels\t\t\tLabel every actor with its connected component.\n"
+    "\tdiffusion seeds [steps]\tSpread score from the actors in seeds, "
+    "listing actors by score.\n"
+    "\ttop metric n [decade]\tList the n actors ranked highest by metric: "
+    "degree, costars or movies.\n"
+    "\tranks names\t\tList the ranks of the actors in names by every "
+    "metric.\n"
+    "\tprofile\t\t\tReport degree, cast size, year and component "
+    "distributions.\n"
+    "\tsketch [repetitions]\tBuild the distance sketches, reporting their "
+    "size, query time and stretch.\n"
+    "\tautotune [pairs]\tTime thread counts, batch sizes and engines on "
+    "random pairs, saving the fastest beside data.tsv.\n"
+    "\tmemory\t\t\tReport the bytes held by each graph and index "
+    "structure.\n"
+    "\ttriangles [check]\tCount the triangles of co-stars through every actor "
+    "and its clustering.\n"
+    "\tbutterflies\t\tCount the butterflies through every actor and its "
+    "tip number.\n"
+    "\twings\t\t\tCount the butterflies through every role and its wing "
+    "number.\n"
+    "\tbicore [check [n]]\tIndex the (alpha, beta)-cores of actors and "
+    "movies, listing the densest core of each alpha.\n"
+    "\tseparation [b]\t\tEstimate the distribution of hops between actors "
+    "and every actor's harmonic centrality.\n"
+    "\tembedding [d]\t\tEmbed every actor in d dimensions from the "
+    "spectrum of the graph, with its eigenvector centrality.\n"
+    "\tsparsify method amount [tolerance]\n"
+    "\t\t\t\tWrite a smaller data.tsv by cast, resistance or local "
+    "sampling, reporting how far it strays.\n";
+
+// Function declarations for main
+static bool ReadNames(const char*, vector<int>&);
+static int RunLabels(const vector<string>&, ofstream&);
+static int RunDiffusion(const vector<string>&, ofstream&);
+static int RunTop(const vector<string>&, ofstream&);
+static int RunRanks(const vector<string>&, ofstream&);
+static int RunProfile(const vector<string>&, ofstream&);
+static int RunSketch(const vector<string>&, ofstream&);
+static int RunAutotune(const vector<string>&, ofstream&);
+static int RunMemory(const vector<string>&, ofstream&);
+static int RunTriangles(const vector<string>&, ofstream&);
+static int RunButterflies(const vector<string>&, ofstream&);
+static int RunWings(const vector<string>&, ofstream&);
+static int RunBiCore(const vector<string>&, ofstream&);
+static int RunSeparation(const vector<string>&, ofstream&);
+static int RunEmbedding(const vector<string>&, ofstream&);
+static int RunSparsify(const vector<string>&, ofstream&);
+
+// Actors and movies read from the tsv file, with actor ids in name order
+static ActorGraph actor_graph;
+
+// Parameters tuned for the tsv file on this host
+static Tuning* tuning;
+
+// Name of the output file, which the sparsify mode reads back
+static string output_name;
+
+// Name of the tsv file, which autotune reloads with movie weights
+static string tsv_name;
+
+// Sparse adjacency matrix of actors sharing a movie
+static CsrMatrix<char> graph;
+
+// Rankings of actors by connectedness, built for the ranking modes
+static RankIndex rankings;
+
+// Names of the ranked metrics, in RankMetric order
+const static string METRIC_NAMES[NUM_METRICS] = {"degree", "costars",
+                                                 "movies"};
+
+
+/*
+ * Loads the graph and runs the analysis selected by mode.
+ *
+ * Parameters:
+ *  argv[1] - data.tsv
+ *      Tab delimited file of movie actor relationships. Header row expected.
+ *      Rows should be formatted as actor name, movie title, and movie year.
+ *  argv[2] - mode
+ *      Analysis to run, see USAGE.
+ *  argv[3] - output
+ *      Name of file to create for the results of the analysis.
+ *  argv[4...] - mode arguments
+ *      Arguments specific to the mode, see USAGE.
+ *
+ * Return:
+ *  int -
+ *      Exit status. -1 for unsuccessful reading or parsing, 0 otherwise.
+ */
+int main(int argc, char *argv[]) {
+    TRACE_FILE(string(argv[0]) + ".trace.json");
+    TRACE_THREAD("main");
+    if (argc < 4) {
+        cout << USAGE;
+        return -1;
+    }
+    string mode(argv[2]);
+    vector<string> args(argv + 4, argv + argc);
+
+    // Analyses run with the tuned threads, which autotune measures afresh
+    Tuning tuned(argv[1]);
+    tuning = &tuned;
+    if (mode != "autotune" && tuned.load())
+        setNumThreads(tuned.getInt("threads", 0));
+
+    output_name = argv[3];
+    tsv_name = argv[1];
+    ofstream out_file(argv[3]);
+    if (!out_file || !actor_graph.loadFromFile(argv[1], false)) {
+        cout << "Failed to read or open files!\n";
+        return -1;
+    }
+    graph = coStarMatrix(actor_graph);
+    cout << "Loaded " << actor_graph.numActors() << " actors, "
+         << actor_graph.numMovies() << " movies, " << graph.nnz() / 2
+         << " connections ..." << endl;
+
+    int status = -1;
+    if (mode == "labels" && args.empty()) {
+        status = RunLabels(args, out_file);
+    } else if (mode == "diffusion" && (args.size() == 1 || args.size() == 2)) {
+        status = RunDiffusion(args, out_file);
+    } else if (mode == "top" && (args.size() == 2 || args.size() == 3)) {
+        status = RunTop(args, out_file);
+    } else if (mode == "ranks" && args.size() == 1) {
+        status = RunRanks(args, out_file);
+    } else if (mode == "profile" && args.empty()) {
+        status = RunProfile(args, out_file);
+    } else if (mode == "sketch" && args.size() <= 1) {
+        status = RunSketch(args, out_file);
+    } else if (mode == "autotune" && args.size() <= 1) {
+        status = RunAutotune(args, out_file);
+    } else if (mode == "memory" && args.empty()) {
+        status = RunMemory(args, out_file);
+    } else if (mode == "triangles" && args.size() <= 1) {
+        status = RunTriangles(args, out_file);
+    } else if (mode == "butterflies" && args.empty()) {
+        status = RunButterflies(args, out_file);
+    } else if (mode == "wings" && args.empty()) {
+        status = RunWings(args, out_file);
+    } else if (mode == "bicore" && args.size() <= 2) {
+        status = RunBiCore(args, out_file);
+    } else if (mode == "separation" && args.size() <= 1) {
+        status = RunSeparation(args, out_file);
+    } else if (mode == "embedding" && args.size() <= 1) {
+        status = RunEmbedding(args, out_file);
+    } else if (mode == "sparsify" && (args.size() == 2 || args.size() == 3)) {
+        status = RunSparsify(args, out_file);
+    } else {
+        cout << USAGE;
+    }
+
+    out_file.close();
+    return status;
+}
+
+
+/*
+ * Reads actor names, one per line after a header, into actor ids. Unknown
+ * actors are reported and skipped.
+ *
+ * Parameters:
+ *  filename -
+ *      File of actor names with a header row.
+ *  ids -
+ *      Receives the ids of the known actors.
+ *
+ * Return:
+ *  bool -
+ *      True indicates successful reading of the file.
+ */
+static bool ReadNames(const char* filename, vector<int>& ids) {
+    ifstream in(filename);
+    if (!in)
+        return false;
+    string line;
+    getline(in, line);
+    while (getline(in, line)) {
+        int id = actor_graph.actorId(line);
+        if (id < 0)
+            cout << "Unknown actor (" << line << ")" << endl;
+        else
+            ids.push_back(id);
+    }
+    return true;
+}
+
+
+// Combiner keeping the smaller of two labels
+struct MinCombiner {
+    int operator()(int x, int y) const { return min(x, y); }
+};
+
+/*
+ * Labels each actor with the smallest actor id of its connected component by
+ * label spreading: every actor adopts the smallest label it hears of and
+ * forwards it to its neighbors until no label changes. Writes each actor
+ * with the name of the actor its component is labelled by.
+ */
+static int RunLabels(const vector<string>&, ofstream& out_file) {
+    typedef PregelEngine<char, int, int, MinCombiner> Engine;
+    Engine engine(graph, 0);
+    int steps = engine.run([](Engine::Context& c) {
+        int label = c.superstep() == 0 ? c.vertex() : c.value();
+        if (c.hasMessage())
+            label = min(label, c.message());
+        if (c.superstep() == 0 || label < c.value()) {
+            c.value() = label;
+            c.sendToNeighbors(label);
+        }
+        c.voteToHalt();
+    });
+    cout << "Labels settled after " << steps << " supersteps ..." << endl;
+
+    const vector<int>& labels = engine.result();
+    out_file << "Actor\tComponent\n";
+    for (int v = 0; v < actor_graph.numActors(); v++) {
+        out_file << actor_graph.actorName(v) << '\t'
+                 << actor_graph.actorName(labels[v]) << '\n';
+    }
+    return 0;
+}
+
+
+// Combiner and aggregator summing scores
+struct SumCombiner {
+    double operator()(double x, double y) const { return x + y; }
+};
+
+/*
+ * Spreads score from seed actors by random walk with restart: each superstep
+ * an actor keeps the restart share of its seed score and passes the rest of
+ * its score evenly to its neighbors. Stops once the total change of a
+ * superstep falls under a tolerance, or after the given number of steps.
+ * Writes actors with non-zero score, highest first.
+ *
+ * Mode arguments:
+ *  args[0] - seeds
+ *      File of seed actor names with a header row.
+ *  args[1] - steps
+ *      Optional maximum number of supersteps, 50 by default.
+ */
+static int RunDiffusion(const vector<string>& args, ofstream& out_file) {
+    const double restart = 0.15;
+    const double tolerance = 1e-9;
+    int max_steps = 50;
+    if (args.size() > 1 && (!parseInt(args[1], max_steps) || max_steps < 0)) {
+        cout << USAGE;
+        return -1;
+    }
+
+    vector<int> seeds;
+    if (!ReadNames(args[0].c_str(), seeds) || seeds.empty()) {
+        cout << "Failed to read seeds!\n";
+        return -1;
+    }
+    vector<double> seed_score(actor_graph.numActors(), 0.0);
+    for (int s : seeds)
+        seed_score[s] += restart / seeds.size();
+
+    typedef PregelEngine<char, double, double, SumCombiner,
+                         double, SumCombiner> Engine;
+    Engine engine(graph, 0.0, 0.0);
+    int steps = engine.run([&](Engine::Context& c) {
+        double score = seed_score[c.vertex()];
+        if (c.hasMessage())
+            score += c.message();
+        c.aggregate(fabs(score - c.value()));
+        c.value() = score;
+        // Stop spreading once the previous superstep barely changed scores
+        if (c.superstep() > 1 && c.aggregated() < tolerance) {
+            c.voteToHalt();
+            return;
+        }
+        if (c.degree())
+            c.sendToNeighbors((1 - restart) * score / c.degree());
+        c.voteToHalt();
+    }, max_steps);
+    cout << "Diffusion ran " << steps << " supersteps ..." << endl;
+
+    const vector<double>& scores = engine.result();
+    vector<pair<double, int>> ranked;
+    for (int v = 0; v < actor_graph.numActors(); v++) {
+        if (scores[v] > 0)
+            ranked.push_back(pair<double, int>(-scores[v], v));
+    }
+    sort(ranked.begin(), ranked.end());
+    out_file << "Actor\tScore\n";
+    for (auto& r : ranked)
+        out_file << actor_graph.actorName(r.second) << '\t' << -r.first
+                 << '\n';
+    return 0;
+}
+
+
+// Builds the rankings index, reporting the time taken.
+static void BuildRankings() {
+    auto start = chrono::steady_clock::now();
+    rankings.build(actor_graph);
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    cout << "Ranked actors in " << elapsed.count() << "s ..." << endl;
+}
+
+
+/*
+ * Lists the actors ranked highest by a metric, overall or within a decade,
+ * with their values.
+ *
+ * Mode arguments:
+ *  args[0] - metric
+ *      One of degree, costars or movies.
+ *  args[1] - n
+ *      Number of actors to list.
+ *  args[2] - decade
+ *      Optional year of a decade to rank within, e.g. 1990 or 1994 for the
+ *      1990s.
+ */
+static int RunTop(const vector<string>& args, ofstream& out_file) {
+    int metric = find(METRIC_NAMES, METRIC_NAMES + NUM_METRICS, args[0]) -
+                 METRIC_NAMES;
+    if (metric == NUM_METRICS) {
+        cout << "Unknown metric (" << args[0] << ")" << endl;
+        return -1;
+    }
+    int n, decade = 0;
+    if (!parseInt(args[1], n) || n < 0 ||
+        (args.size() > 2 && !parseInt(args[2], decade))) {
+        cout << USAGE;
+        return -1;
+    }
+    BuildRankings();
+    int period = 0;
+    if (args.size() > 2) {
+        period = rankings.period(decade);
+        if (period < 0) {
+            cout << "No movies from decade (" << args[2] << ")" << endl;
+            return -1;
+        }
+    }
+
+    RankMetric m = (RankMetric)metric;
+    n = min(n, rankings.numRanked(m, period));
+    out_file << "Rank\tActor\t" << METRIC_NAMES[metric] << '\n';
+    for (int r = 0; r < n; r++) {
+        int actor = rankings.actorAt(m, period, r);
+        out_file << r + 1 << '\t' << actor_graph.actorName(actor) << '\t'
+                 << rankings.valueOf(m, period, actor) << '\n';
+    }
+    return 0;
+}
+
+
+/*
+ * Lists the overall rank and value of actors by every metric. Ranks count
+ * from 1.
+ *
+ * Mode arguments:
+ *  args[0] - names
+ *      File of actor names with a header row.
+ */
+static int RunRanks(const vector<string>& args, ofstream& out_file) {
+    vector<int> actors;
+    if (!ReadNames(args[0].c_str(), actors)) {
+        cout << "Failed to read names!\n";
+        return -1;
+    }
+    BuildRankings();
+
+    out_file << "Actor";
+    for (int m = 0; m < NUM_METRICS; m++)
+        out_file << '\t' << METRIC_NAMES[m] << '\t' << METRIC_NAMES[m]
+                 << " rank";
+    out_file << '\n';
+    for (int actor : actors) {
+        out_file << actor_graph.actorName(actor);
+        for (int m = 0; m < NUM_METRICS; m++)
+            out_file << '\t' << rankings.valueOf((RankMetric)m, 0, actor)
+                     << '\t' << rankings.rankOf((RankMetric)m, 0, actor) + 1;
+        out_file << '\n';
+    }
+    return 0;
+}
+
+
+// Histograms and totals gathered by one thread of the profile pass.
+struct ProfileCounts {
+    vector<long long> costars;      // actors by log2 bucket of co-stars
+    vector<long long> filmography;  // actors by log2 bucket of movies
+    vector<long long> cast;         // movies by log2 bucket of cast size
+    map<int, long long> years;      // movies by year
+    long long cast_work = 0;        // sum over movies of cast size squared
+    long long two_hop_work = 0;     // sum over actors of co-stars squared
+    long long roles = 0;            // sum over movies of cast size
+};
+
+// Log2 bucket of n: 0 for 0, b + 1 for n in [2^b, 2^(b+1)).
+static int LogBucket(long long n) {
+    int b = 0;
+    while (n > 0) {
+        n >>= 1;
+        b++;
+    }
+    return b;
+}
+
+// Adds one to bucket b of hist, growing it as needed.
+static void CountBucket(vector<long long>& hist, int b) {
+    if ((int)hist.size() <= b)
+        hist.resize(b + 1, 0);
+    hist[b]++;
+}
+
+// Adds the buckets of from to hist.
+static void MergeHistogram(vector<long long>& hist,
+                           const vector<long long>& from) {
+    if (hist.size() < from.size())
+        hist.resize(from.size(), 0);
+    for (size_t b = 0; b < from.size(); b++)
+        hist[b] += from[b];
+}
+
+// Writes a log2 bucketed histogram under a title.
+static void WriteHistogram(ofstream& out_file, const string& title,
+                           const vector<long long>& hist) {
+    out_file << '\n' << title << '\n';
+    for (int b = 0; b < (int)hist.size(); b++) {
+        if (!hist[b])
+            continue;
+        long long lo = b ? 1LL << (b - 1) : 0;
+        long long hi = b ? (1LL << b) - 1 : 0;
+        out_file << lo;
+        if (hi > lo)
+            out_file << '-' << hi;
+        out_file << '\t' << hist[b] << '\n';
+    }
+}
+
+/*
+ * Finds the connected components of a graph by union-find, joining each cast
+ * to its first actor.
+ *
+ * Parameters:
+ *  g -
+ *      Loaded graph.
+ *
+ * Return:
+ *  vector -
+ *      Size of the component of each actor at the index of its smallest
+ *      actor, 0 at the other indices.
+ */
+static vector<int> ComponentSizes(const ActorGraph& g) {
+    int num_actors = g.numActors();
+    vector<int> parent(num_actors);
+    for (int a = 0; a < num_actors; a++)
+        parent[a] = a;
+    auto root = [&parent](int a) {
+        while (parent[a] != a)
+            a = parent[a] = parent[parent[a]];
+        return a;
+    };
+    for (int m = 0; m < g.numMovies(); m++) {
+        IdRange cast = g.castOf(m);
+        for (int a : cast) {
+            int x = root(*cast.first);
+            int y = root(a);
+            if (x != y)
+                parent[max(x, y)] = min(x, y);
+        }
+    }
+    vector<int> component_size(num_actors, 0);
+    for (int a = 0; a < num_actors; a++)
+        component_size[root(a)]++;
+    return component_size;
+}
+
+// Share of a total held by its largest percent of the values, as a percent.
+static double TopShare(vector<long long> values, double percent) {
+    long long total = 0;
+    for (long long v : values)
+        total += v;
+    if (!total)
+        return 0;
+    size_t k = max((size_t)1, (size_t)(values.size() * percent / 100));
+    k = min(k, values.size());
+    nth_element(values.begin(), values.begin() + (k - 1), values.end(),
+                greater<long long>());
+    long long top = 0;
+    for (size_t i = 0; i < k; i++)
+        top += values[i];
+    return 100.0 * top / total;
+}
+
+/*
+ * Reports the shape of the graph: distributions of co-stars and movies per
+ * actor, cast sizes, movies per year and component sizes, the largest hubs,
+ * and estimates of the work of the main kernels. Actors and movies are
+ * counted in one parallel pass into per thread histograms, which are then
+ * merged. Components are found by union-find over the casts.
+ *
+ * Kernel work estimates:
+ *  clique expansion - sum of cast size squared, the work of building the
+ *                     co-star connections from the casts.
+ *  two hop          - sum of co-stars squared, the work of counting mutual
+ *                     co-stars as the predictor and triangle kernels do.
+ *  traversal        - number of roles, the work of a search expanding every
+ *                     movie once as the pathfinder does.
+ */
+static int RunProfile(const vector<string>&, ofstream& out_file) {
+    int num_actors = actor_graph.numActors();
+    int num_movies = actor_graph.numMovies();
+    auto start = chrono::steady_clock::now();
+
+    // Count actors and movies in one pass, ids past the actors being movies,
+    // keeping the work of each for the hub shares
+    vector<ProfileCounts> counts(numThreads());
+    vector<long long> cast_work(num_movies);
+    vector<long long> two_hop_work(num_actors);
+    parallelFor(0, num_actors + num_movies, 1024,
+                [&](int lo, int hi, int t) {
+        ProfileCounts& c = counts[t];
+        for (int i = lo; i < hi; i++) {
+            if (i < num_actors) {
+                long long d = graph.rowSize(i);
+                CountBucket(c.costars, LogBucket(d));
+                CountBucket(c.filmography,
+                            LogBucket(actor_graph.moviesOf(i).size()));
+                two_hop_work[i] = d * d;
+                c.two_hop_work += d * d;
+            } else {
+                int m = i - num_actors;
+                long long size = actor_graph.castOf(m).size();
+                CountBucket(c.cast, LogBucket(size));
+                c.years[actor_graph.movieYear(m)]++;
+                cast_work[m] = size * size;
+                c.cast_work += size * size;
+                c.roles += size;
+            }
+        }
+    });
+
+    // Merge the per thread counts
+    ProfileCounts total;
+    for (ProfileCounts& c : counts) {
+        MergeHistogram(total.costars, c.costars);
+        MergeHistogram(total.filmography, c.filmography);
+        MergeHistogram(total.cast, c.cast);
+        for (auto& y : c.years)
+            total.years[y.first] += y.second;
+        total.cast_work += c.cast_work;
+        total.two_hop_work += c.two_hop_work;
+        total.roles += c.roles;
+    }
+
+    map<int, int> components;
+    for (int size : ComponentSizes(actor_graph))
+        if (size)
+            components[size]++;
+
+    // Largest hubs by distinct co-stars
+    vector<pair<int, int>> hubs;
+    for (int a = 0; a < num_actors; a++)
+        hubs.push_back(pair<int, int>(-graph.rowSize(a), a));
+    size_t num_hubs = min((size_t)10, hubs.size());
+    partial_sort(hubs.begin(), hubs.begin() + num_hubs, hubs.end());
+    hubs.resize(num_hubs);
+
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    cout << "Profiled graph in " << elapsed.count() << "s ..." << endl;
+
+    // Write the report
+    out_file << "Actors\t" << num_actors << '\n'
+             << "Movies\t" << num_movies << '\n'
+             << "Roles\t" << total.roles << '\n'
+             << "Connections\t" << graph.nnz() / 2 << '\n';
+    WriteHistogram(out_file, "Co-stars per actor", total.costars);
+    WriteHistogram(out_file, "Movies per actor", total.filmography);
+    WriteHistogram(out_file, "Cast size", total.cast);
+    out_file << "\nMovies per year\n";
+    for (auto& y : total.years)
+        out_file << y.first << '\t' << y.second << '\n';
+    out_file << "\nComponent sizes\n";
+    for (auto& c : components)
+        out_file << c.first << '\t' << c.second << '\n';
+    out_file << "\nLargest hubs\tCo-stars\tMovies\n";
+    for (auto& h : hubs)
+        out_file << actor_graph.actorName(h.second) << '\t' << -h.first
+                 << '\t' << actor_graph.moviesOf(h.second).size() << '\n';
+
+    double cast_share = TopShare(cast_work, 1);
+    double hub_share = TopShare(two_hop_work, 1);
+    out_file << "\nKernel work\n"
+             << "Clique expansion\t" << total.cast_work << '\n'
+             << "Two hop\t" << total.two_hop_work << '\n'
+             << "Traversal\t" << total.roles << '\n'
+             << "Clique expansion per connection\t"
+             << (graph.nnz() ? (double)total.cast_work / graph.nnz() : 0)
+             << '\n'
+             << "Largest 1% of casts share of clique expansion\t"
+             << cast_share << "%\n"
+             << "Largest 1% of hubs share of two hop\t" << hub_share
+             << "%\n";
+    out_file << "Dominant kernel\t"
+             << (total.cast_work >= total.two_hop_work ? "clique expansion"
+                                                       : "two hop")
+             << '\n'
+             << "Hub handling needed\t"
+             << (max(cast_share, hub_share) >= 50 ? "yes" : "no") << '\n';
+    return 0;
+}
+
+
+/*
+ * Builds the distance sketches and measures them against exact hops from a
+ * sample of actors: time to build, bytes against exact labels of one byte
+ * per pair, time per estimate, and the stretch of the estimates, estimated
+ * over true hops. Writes the mean estimate and stretch by true hops.
+ *
+ * Mode arguments:
+ *  args[0] - repetitions
+ *      Optional number of seed sets drawn of each size, 2 by default.
+ */
+static int RunSketch(const vector<string>& args, ofstream& out_file) {
+    int repetitions = 2;
+    if (!args.empty() && (!parseInt(args[0], repetitions) || repetitions < 1)) {
+        cout << USAGE;
+        return -1;
+    }
+    int num_actors = actor_graph.numActors();
+    auto start = chrono::steady_clock::now();
+    DistanceSketch sketch;
+    sketch.build(actor_graph, repetitions);
+    chrono::duration<double> build_time = chrono::steady_clock::now() - start;
+    cout << "Built " << sketch.numSets() << " seed sets in " 
+         << build_time.count() << "s, " << sketch.bytes() / 1024 
+         << " KiB against " << (long long)num_actors * num_actors / 1024 
+         << " KiB of exact labels ..." << endl;
+
+    // Exact hops from a sample of actors, compared with every estimate
+    const int SOURCES = 64;
+    int sources = min(SOURCES, num_actors);
+    vector<long long> pairs;
+    vector<double> estimated;
+    vector<double> stretched;
+    long long exact = 0;
+    long long total = 0;
+    double max_stretch = 1;
+    double query_seconds = 0;
+    SearchState state(actor_graph);
+    vector<int> estimates(num_actors);
+    for (int i = 0; i < sources; i++) {
+        int source = (int)((long long)i * num_actors / sources);
+        auto begin = chrono::steady_clock::now();
+        for (int v = 0; v < num_actors; v++)
+            estimates[v] = sketch.estimate(source, v);
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - 
+                                           begin;
+        query_seconds += elapsed.count();
+
+        state.reset();
+        FifoFrontier frontier(state);
+        addSource(state, frontier, source);
+        TraversalVisitor visitor;
+        traverse(actor_graph, state, frontier, UnitWeight(), visitor);
+        for (int v : state.touched) {
+            int hops = state.dist[v];
+            if (hops == 0)
+                continue;
+            if (hops >= (int)pairs.size()) {
+                pairs.resize(hops + 1, 0);
+                estimated.resize(hops + 1, 0);
+                stretched.resize(hops + 1, 0);
+            }
+            double stretch = (double)estimates[v] / hops;
+            pairs[hops]++;
+            estimated[hops] += estimates[v];
+            stretched[hops] += stretch;
+            max_stretch = max(max_stretch, stretch);
+            exact += estimates[v] == hops;
+            total++;
+        }
+    }
+
+    double mean_stretch = 0;
+    out_file << "Hops\tPairs\tMean estimate\tMean stretch\n";
+    for (size_t h = 1; h < pairs.size(); h++) {
+        if (!pairs[h])
+            continue;
+        out_file << h << '\t' << pairs[h] << '\t' << estimated[h] / pairs[h]
+                 << '\t' << stretched[h] / pairs[h] << '\n';
+        mean_stretch += stretched[h];
+    }
+    double levels = max(1.0, log2((double)max(num_actors, 2)));
+    cout << "Estimated " << (long long)sources * num_actors << " pairs at "
+         << 1e9 * query_seconds / max(1LL, (long long)sources * num_actors)
+         << "ns each ..." << endl;
+    cout << "Stretch " << mean_stretch / max(1LL, total) << " mean, " 
+         << max_stretch << " max (bound " << 2 * floor(levels) - 1 
+         << "), " << 100.0 * exact / max(1LL, total) << "% exact" << endl;
+    return 0;
+}
+
+
+// Runs of each setting timed by autotune, keeping the fastest
+const static int TUNE_ROUNDS = 3;
+
+// Fraction by which a setting must beat the simpler ones to be chosen
+const static double TUNE_MARGIN = 0.05;
+
+
+/*
+ * Times a run of autotune, writing the time to the report.
+ *
+ * Parameters:
+ *  out_file -
+ *      Report of autotune.
+ *  parameter, setting -
+ *      Parameter and setting timed.
+ *  run -
+ *      Runs the setting once.
+ *
+ * Return:
+ *  double -
+ *      Seconds of the fastest of TUNE_ROUNDS runs.
+ */
+template <class Run>
+static double TimeSetting(ofstream& out_file, const string& parameter,
+                          double setting, Run run) {
+    double best = 0;
+    for (int round = 0; round < TUNE_ROUNDS; round++) {
+        auto start = chrono::steady_clock::now();
+        run();
+        chrono::duration<double> elapsed = chrono::steady_clock::now() -
+                                           start;
+        if (round == 0 || elapsed.count() < best)
+            best = elapsed.count();
+    }
+    out_file << parameter << '\t' << setting << '\t' << best << '\n';
+    return best;
+}
+
+
+/*
+ * Chooses a setting from their times: the first, unless a later one beats
+ * the chosen one by TUNE_MARGIN. Settings are ordered simplest first, so
+ * more threads or searches must pay for themselves.
+ *
+ * Parameters:
+ *  settings, seconds -
+ *      Settings timed and the time of each.
+ *
+ * Return:
+ *  int -
+ *      Setting chosen.
+ */
+static int ChooseSetting(const vector<int>& settings,
+                         const vector<double>& seconds) {
+    size_t chosen = 0;
+    for (size_t i = 1; i < settings.size(); i++) {
+        if (seconds[i] < seconds[chosen] * (1 - TUNE_MARGIN))
+            chosen = i;
+    }
+    return settings[chosen];
+}
+
+
+/*
+ * Tunes the parameters of the engines on this host by timing short runs
+ * over random pairs of actors, and saves them beside data.tsv, where every
+ * program reads them at startup. Tuned in turn, each with the settings
+ * chosen before it:
+ *
+ *  threads    - 1, 2, 4 and so on up to the hardware threads, finding paths.
+ *  interleave - 1, 2, 4 and 8 searches interleaved per thread.
+ *  batch      - 16, 64 and 256 pairs per batch, streaming the pairs through
+ *               the pipeline.
+ *  planner    - the time per role scanned of each engine of the query
+ *               planner, answering with that engine alone the pairs it is
+ *               planned for, over the roles it scanned answering them.
+ *  buckets    - 1, 2, 4 and 8 wide distance buckets (see BucketFrontier),
+ *               finding weighted distances as pathfinder w does.
+ *
+ * Writes the time of every setting tried.
+ *
+ * Mode arguments:
+ *  args[0] - pairs
+ *      Optional number of random pairs timed, 256 by default.
+ */
+static int RunAutotune(const vector<string>& args, ofstream& out_file) {
+    int num_pairs = 256;
+    if (!args.empty() && (!parseInt(args[0], num_pairs) || num_pairs <= 0)) {
+        cout << USAGE;
+        return -1;
+    }
+    int num_actors = actor_graph.numActors();
+    if (num_actors == 0)
+        return -1;
+
+    // Random pairs, the same every run
+    mt19937 random(1);
+    vector<pair<int, int>> pairs(num_pairs);
+    string rows;
+    for (auto& p : pairs) {
+        p.first = (int)(random() % (unsigned)num_actors);
+        p.second = (int)(random() % (unsigned)num_actors);
+        rows += actor_graph.actorName(p.first) + '\t' +
+                actor_graph.actorName(p.second) + '\n';
+    }
+    vector<string> paths;
+    out_file << "Parameter\tSetting\tSeconds\n";
+
+    // Threads, finding paths one search at a time
+    vector<int> settings;
+    vector<double> seconds;
+    int hardware = max(1, (int)thread::hardware_concurrency());
+    for (int t = 1; t < hardware; t *= 2)
+        settings.push_back(t);
+    settings.push_back(hardware);
+    for (int t : settings) {
+        setNumThreads(t);
+        seconds.push_back(TimeSetting(out_file, "threads", t, [&]() {
+            findPaths(actor_graph, pairs, paths, 1);
+        }));
+    }
+    int threads = ChooseSetting(settings, seconds);
+    setNumThreads(threads);
+
+    // Searches interleaved by each thread
+    settings = {1, 2, 4, 8};
+    seconds.clear();
+    for (int g : settings) {
+        seconds.push_back(TimeSetting(out_file, "interleave", g, [&]() {
+            findPaths(actor_graph, pairs, paths, g);
+        }));
+    }
+    int interleave = ChooseSetting(settings, seconds);
+
+    // Pairs per batch of the pipeline; the default is tried first
+    PipelineOptions pipeline;
+    pipeline.interleave = interleave;
+    settings = {pipeline.batch, 16, 256};
+    seconds.clear();
+    for (int b : settings) {
+        pipeline.batch = b;
+        seconds.push_back(TimeSetting(out_file, "batch", b, [&]() {
+            istringstream in(rows);
+            streamPaths(actor_graph, in, 0, pipeline,
+                        [](const vector<string>&, size_t) {});
+        }));
+    }
+    int batch = ChooseSetting(settings, seconds);
+
+    // Time per role scanned of each engine, answering alone the query it
+    // serves best. Only the pairs planned to the engine are timed, and their
+    // time is divided by the roles the engine scanned for those pairs.
+    DistanceSketch sketch;
+    sketch.build(actor_graph, 2);
+    PlannerIndex index;
+    index.build(actor_graph, false, &sketch);
+    PathSearcher searcher(actor_graph, 1);
+    const Engine engines[] = {SKETCH_LOOKUP, BIDIRECTIONAL_BFS, DIJKSTRA};
+    const PairQuery queries[] = {ESTIMATE_PAIR, ESTIMATE_PAIR, DISTANCE_PAIR};
+    double scale[NUM_ENGINES] = {1, 1, 1, 1};
+    for (int i = 0; i < 3; i++) {
+        Engine e = engines[i];
+        fill(index.enabled, index.enabled + NUM_ENGINES, false);
+        index.enabled[e] = true;
+        QueryPlanner planner(actor_graph, index, nullptr, searcher);
+        vector<pair<int, int>> planned;
+        for (const auto& p : pairs) {
+            if (planner.plan(queries[i], p.first, p.second).engine == e)
+                planned.push_back(p);
+        }
+        vector<string> answers;
+        PlanLog log;
+        planner.answer(queries[i], planned, answers, &log, 0);
+        double roles = (double)log.actual[e];
+        double time = TimeSetting(out_file, string("planner-") +
+                                  ENGINE_NAMES[e], roles, [&]() {
+            planner.answer(queries[i], planned, answers, nullptr, 0);
+        });
+        if (roles > 0)
+            scale[e] = 1e9 * time / roles;
+    }
+
+    // Width of the distance buckets of weighted searches, over the graph
+    // with movie weights; actor ids follow names, so the pairs carry over
+    ActorGraph weighted;
+    if (!weighted.loadFromFile(tsv_name.c_str(), true))
+        return -1;
+    SearchState state(weighted);
+    settings = {1, 2, 4, 8};
+    seconds.clear();
+    for (int w : settings) {
+        BucketFrontier frontier(state, w);
+        seconds.push_back(TimeSetting(out_file, "bucket-width", w, [&]() {
+            for (const auto& p : pairs) {
+                state.reset();
+                frontier.clear();
+                addSource(state, frontier, p.first);
+                TargetVisitor visitor(p.second);
+                traverse(weighted, state, frontier, MovieWeight(), visitor);
+            }
+        }));
+    }
+    int bucket_width = ChooseSetting(settings, seconds);
+
+    tuning->set("threads", threads);
+    tuning->set("interleave", interleave);
+    tuning->set("batch", batch);
+    tuning->set("bucket-width", bucket_width);
+    for (Engine e : engines)
+        tuning->set(string("planner-") + ENGINE_NAMES[e], scale[e]);
+    if (!tuning->save()) {
+        cout << "Failed to write " << tuning->file() << "!\n";
+        return -1;
+    }
+    cout << "Tuned " << threads << " threads x " << interleave
+         << " searches, batches of " << batch << ", buckets of "
+         << bucket_width << "; planner ns per role: "
+         << "sketch " << scale[SKETCH_LOOKUP] << ", bidirectional "
+         << scale[BIDIRECTIONAL_BFS] << ", dijkstra " << scale[DIJKSTRA]
+         << " ..." << endl;
+    cout << "Saved to " << tuning->file() << endl;
+    return 0;
+}
+
+
+/*
+ * Builds every index of the programs over the graph and writes the bytes
+ * held by each structure: the graph, the co-star matrix and sets, the
+ * rankings, the distance sketches and the planner statistics. See
+ * memory.hpp.
+ */
+static int RunMemory(const vector<string>&, ofstream& out_file) {
+    BuildRankings();
+    DistanceSketch sketch;
+    sketch.build(actor_graph, 2);
+    PlannerIndex index;
+    index.build(actor_graph, false, &sketch);
+    NeighborSets sets;
+    sets.build(graph);
+    BiCoreIndex cores;
+    cores.build(actor_graph);
+
+    MemoryReport memory;
+    actor_graph.memoryUsage(memory);
+    memory.add("co-star matrix", graph.bytes());
+    memory.add("co-star sets", sets.bytes());
+    memory.add("rankings", rankings.bytes());
+    memory.add("distance sketches", sketch.bytes());
+    memory.add("planner index", index.bytes());
+    memory.add("bicore index", cores.bytes());
+    memory.write(out_file);
+    cout << "Accounted " << memory.total() << " bytes of a resident set of "
+         << residentBytes() << " bytes ..." << endl;
+    return 0;
+}
+
+
+/*
+ * Counts the triangles of co-stars through every actor, the pairs of its
+ * co-stars who are co-stars themselves, as half the sum over its co-stars v
+ * of the co-stars it shares with v. Shared co-stars are counted by
+ * intersecting adaptive neighbor sets (see neighborsets.hpp). Writes each
+ * actor's co-stars, triangles and clustering, the share of pairs of its
+ * co-stars who co-star.
+ *
+ * Mode arguments:
+ *  args[0] - check
+ *      Optional, the word check to count once more by merging sorted
+ *      matrix rows, reporting the time of both and whether they agree.
+ */
+static int RunTriangles(const vector<string>& args, ofstream& out_file) {
+    bool check = !args.empty();
+    if (check && args[0] != "check") {
+        cout << USAGE;
+        return -1;
+    }
+    int num_actors = actor_graph.numActors();
+    auto start = chrono::steady_clock::now();
+    NeighborSets sets;
+    sets.build(graph);
+    chrono::duration<double> build_time = chrono::steady_clock::now() - start;
+    long long kinds[NUM_CONTAINER_KINDS];
+    sets.kindCounts(kinds);
+    cout << "Built neighbor sets in " << build_time.count() << "s: "
+         << kinds[ARRAY_CONTAINER] << " arrays, " << kinds[BITMAP_CONTAINER]
+         << " bitmaps, " << kinds[RUN_CONTAINER] << " runs, "
+         << sets.bytes() / 1024 << " KiB against " << graph.bytes() / 1024
+         << " KiB of matrix ..." << endl;
+
+    // Twice the triangles through each actor
+    vector<long long> by_sets(num_actors, 0);
+    start = chrono::steady_clock::now();
+    parallelFor(0, num_actors, 64, [&](int lo, int hi, int) {
+        for (int u = lo; u < hi; u++) {
+            sets.forEach(u, [&](int v) {
+                by_sets[u] += sets.intersectionSize(u, v);
+            });
+        }
+    });
+    chrono::duration<double> set_time = chrono::steady_clock::now() - start;
+
+    long long triangles = 0, wedges = 0;
+    out_file << "Actor\tCo-stars\tTriangles\tClustering\n";
+    for (int u = 0; u < num_actors; u++) {
+        long long degree = sets.size(u);
+        long long pairs = degree * (degree - 1) / 2;
+        triangles += by_sets[u] / 2;
+        wedges += pairs;
+        out_file << actor_graph.actorName(u) << '\t' << degree << '\t'
+                 << by_sets[u] / 2 << '\t'
+                 << (pairs ? (double)(by_sets[u] / 2) / pairs : 0) << '\n';
+    }
+    cout << "Counted " << triangles / 3 << " triangles in " << set_time.count()
+         << "s with neighbor sets" << endl;
+    cout << "Global clustering " << (wedges ? (double)triangles / wedges : 0)
+         << endl;
+    if (!check)
+        return 0;
+
+    // The same counts by merging sorted matrix rows
+    vector<long long> by_rows(num_actors, 0);
+    start = chrono::steady_clock::now();
+    parallelFor(0, num_actors, 64, [&](int lo, int hi, int) {
+        for (int u = lo; u < hi; u++) {
+            const int* u_first = graph.rowIndices(u);
+            const int* u_last = u_first + graph.rowSize(u);
+            for (const int* p = u_first; p < u_last; p++) {
+                const int* v_first = graph.rowIndices(*p);
+                const int* v_last = v_first + graph.rowSize(*p);
+                const int* a = u_first;
+                while (a < u_last && v_first < v_last) {
+                    if (*a < *v_first) {
+                        a++;
+                    } else if (*v_first < *a) {
+                        v_first++;
+                    } else {
+                        by_rows[u]++;
+                        a++;
+                        v_first++;
+                    }
+                }
+            }
+        }
+    });
+    chrono::duration<double> row_time = chrono::steady_clock::now() - start;
+    bool agree = by_sets == by_rows;
+    cout << "Counted again in " << row_time.count() << "s merging rows"
+         << (agree ? ", counts agree" : " (counts differ!)") << endl;
+    return agree ? 0 : -1;
+}
+
+
+/*
+ * Counts the butterflies, pairs of actors sharing two movies, through every
+ * actor and movie by vertex priority (see butterfly.hpp), then peels actors
+ * into tip numbers. Writes each actor's movies, butterflies and tip number,
+ * and reports the actors of the highest tip number, the most cohesive
+ * repertory group.
+ */
+static int RunButterflies(const vector<string>&, ofstream& out_file) {
+    int num_actors = actor_graph.numActors();
+    auto start = chrono::steady_clock::now();
+    ButterflyCounts counts = countButterflies(actor_graph);
+    chrono::duration<double> count_time = chrono::steady_clock::now() - start;
+
+    // Each butterfly has two actors and two movies
+    long long actor_sum = 0, movie_sum = 0;
+    for (long long b : counts.actors)
+        actor_sum += b;
+    for (long long b : counts.movies)
+        movie_sum += b;
+    bool agree = actor_sum == 2 * counts.total &&
+                 movie_sum == 2 * counts.total;
+    cout << "Counted " << counts.total << " butterflies in "
+         << count_time.count() << "s" << (agree ? "" : " (counts differ!)")
+         << " ..." << endl;
+
+    start = chrono::steady_clock::now();
+    vector<long long> tips = tipDecomposition(actor_graph, counts.actors);
+    chrono::duration<double> peel_time = chrono::steady_clock::now() - start;
+    long long top = 0;
+    for (long long tip : tips)
+        top = max(top, tip);
+    int group = 0;
+    out_file << "Actor\tMovies\tButterflies\tTip\n";
+    for (int u = 0; u < num_actors; u++) {
+        group += tips[u] == top;
+        out_file << actor_graph.actorName(u) << '\t'
+                 << actor_graph.moviesOf(u).size() << '\t'
+                 << counts.actors[u] << '\t' << tips[u] << '\n';
+    }
+    cout << "Peeled tip numbers in " << peel_time.count() << "s: " << group
+         << " actors of tip number " << top << endl;
+    return agree ? 0 : -1;
+}
+
+
+/*
+ * Counts the butterflies through every role, the link of an actor to a movie
+ * it is cast in, then peels roles into wing numbers (see butterfly.hpp).
+ * Writes each role's actor, movie, butterflies and wing number, and reports
+ * the roles, actors and movies of the highest wing number.
+ */
+static int RunWings(const vector<string>&, ofstream& out_file) {
+    int num_actors = actor_graph.numActors();
+    auto start = chrono::steady_clock::now();
+    vector<long long> counts = roleButterflies(actor_graph);
+    chrono::duration<double> count_time = chrono::steady_clock::now() - start;
+
+    // Each butterfly has four roles
+    long long sum = 0;
+    for (long long b : counts)
+        sum += b;
+    bool agree = sum % 4 == 0;
+    cout << "Counted " << sum / 4 << " butterflies through "
+         << counts.size() << " roles in " << count_time.count() << "s"
+         << (agree ? "" : " (counts differ!)") << " ..." << endl;
+
+    start = chrono::steady_clock::now();
+    vector<long long> wings = wingDecomposition(actor_graph, counts);
+    chrono::duration<double> peel_time = chrono::steady_clock::now() - start;
+    long long top = 0;
+    for (long long wing : wings)
+        top = max(top, wing);
+    int roles = 0;
+    vector<char> in_actors(num_actors, 0);
+    vector<char> in_movies(actor_graph.numMovies(), 0);
+    out_file << "Actor\tMovie\tButterflies\tWing\n";
+    for (int u = 0; u < num_actors; u++) {
+        int role = actor_graph.firstRole(u);
+        for (int m : actor_graph.moviesOf(u)) {
+            if (wings[role] == top) {
+                roles++;
+                in_actors[u] = in_movies[m] = 1;
+            }
+            out_file << actor_graph.actorName(u) << '\t'
+                     << actor_graph.movieTitle(m) << '\t' << counts[role]
+                     << '\t' << wings[role] << '\n';
+            role++;
+        }
+    }
+    cout << "Peeled wing numbers in " << peel_time.count() << "s: " << roles
+         << " roles of " << count(in_actors.begin(), in_actors.end(), 1)
+         << " actors in " << count(in_movies.begin(), in_movies.end(), 1)
+         << " movies of wing number " << top << endl;
+    return agree ? 0 : -1;
+}
+
+
+/*
+ * Builds the (alpha, beta)-core index (see bicore.hpp) and writes, for every
+ * alpha with a non-empty core, the largest beta with one and the actors and
+ * movies of that core, the densest core whose actors are all cast in alpha
+ * of its movies.
+ *
+ * Mode arguments:
+ *  args[0] - check
+ *      Optional, the word check to find random (alpha, beta) pairs both
+ *      from the index and by peeling, reporting the time of each and
+ *      whether the cores agree.
+ *  args[1] - n
+ *      Optional number of random pairs checked, 100 by default.
+ */
+static int RunBiCore(const vector<string>& args, ofstream& out_file) {
+    int checks = 100;
+    if ((!args.empty() && args[0] != "check") ||
+        (args.size() > 1 && (!parseInt(args[1], checks) || checks < 1))) {
+        cout << USAGE;
+        return -1;
+    }
+    auto start = chrono::steady_clock::now();
+    BiCoreIndex cores;
+    cores.build(actor_graph);
+    chrono::duration<double> build_time = chrono::steady_clock::now() - start;
+    cout << "Built the bicore index in " << build_time.count()
+         << "s: delta " << cores.degeneracy() << ", "
+         << cores.bytes() / 1024 << " KiB ..." << endl;
+
+    int max_alpha = cores.maxAlpha(1);
+    out_file << "Alpha\tBeta\tActors\tMovies\n";
+    for (int alpha = 1; alpha <= max_alpha; alpha++) {
+        int beta = cores.maxBeta(alpha);
+        BiCore core = cores.query(alpha, beta);
+        out_file << alpha << '\t' << beta << '\t' << core.actors.size()
+                 << '\t' << core.movies.size() << '\n';
+    }
+    if (args.empty())
+        return 0;
+
+    // Random pairs within the non-empty cores, the same every run
+    mt19937 random(1);
+    vector<pair<int, int>> pairs(checks);
+    for (auto& p : pairs) {
+        p.first = 1 + (int)(random() % (unsigned)max(max_alpha, 1));
+        p.second = 1 + (int)(random() % (unsigned)max(cores.maxBeta(p.first),
+                                                       1));
+    }
+    vector<BiCore> found(pairs.size());
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < pairs.size(); i++)
+        found[i] = cores.query(pairs[i].first, pairs[i].second);
+    chrono::duration<double> query_time = chrono::steady_clock::now() - start;
+    bool agree = true;
+    chrono::duration<double> peel_time(0);
+    for (size_t i = 0; i < pairs.size(); i++) {
+        start = chrono::steady_clock::now();
+        BiCore peeled = peelBiCore(actor_graph, pairs[i].first,
+                                   pairs[i].second);
+        peel_time += chrono::steady_clock::now() - start;
+        sort(found[i].actors.begin(), found[i].actors.end());
+        sort(found[i].movies.begin(), found[i].movies.end());
+        agree = agree && found[i].actors == peeled.actors &&
+                found[i].movies == peeled.movies;
+    }
+    cout << "Found " << pairs.size() << " cores in " << query_time.count()
+         << "s from the index, " << peel_time.count() << "s peeling"
+         << (agree ? ", cores agree" : " (cores differ!)") << endl;
+    return agree ? 0 : -1;
+}
+
+
+/*
+ * Estimates the neighbourhood function of the co-star graph by HyperANF (see
+ * hyperanf.hpp): the pairs of distinct actors at each number of hops, their
+ * mean hops, the effective diameter (hops within which 90% of connected
+ * pairs lie), and every actor's reach and harmonic centrality, the sum of
+ * one over its hops to every other actor. Searches from a sample of actors
+ * give exact values to report the error of the estimates against. Writes
+ * the summary, the distribution of hops, estimated and sampled, and each
+ * actor's estimates.
+ *
+ * Mode arguments:
+ *  args[0] - b
+ *      Optional base two logarithm of the registers per counter, from 4 to
+ *      16, 8 by default.
+ */
+static int RunSeparation(const vector<string>& args, ofstream& out_file) {
+    int b = 8;
+    if (!args.empty() && (!parseInt(args[0], b) || b < 4 || b > 16)) {
+        cout << USAGE;
+        return -1;
+    }
+    int num_actors = actor_graph.numActors();
+    auto start = chrono::steady_clock::now();
+    NeighborhoodFunction function = hyperAnf(actor_graph, b);
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    const vector<double>& pairs = function.pairs;
+    cout << "Estimated the neighbourhood function in " << elapsed.count()
+         << "s, " << pairs.size() - 1 << " steps ..." << endl;
+
+    // Exact hops from a sample of actors, by breadth first search over the
+    // co-star matrix, which is symmetric and so its own CSC form
+    const int SOURCES = 64;
+    int sources = min(SOURCES, num_actors);
+    vector<long long> sampled;
+    double harmonic_error = 0;
+    for (int i = 0; i < sources; i++) {
+        int source = (int)((long long)i * num_actors / sources);
+        vector<int> levels = bfsLevels(graph, source);
+        double harmonic = 0;
+        for (int hops : levels) {
+            if (hops < 0)
+                continue;
+            if (hops >= (int)sampled.size())
+                sampled.resize(hops + 1, 0);
+            sampled[hops]++;
+            harmonic += hops ? 1.0 / hops : 0;
+        }
+        if (harmonic > 0)
+            harmonic_error += fabs(function.harmonic[source] - harmonic) /
+                              harmonic;
+    }
+
+    double connected = pairs.back() - pairs[0];
+    long long sampled_connected = 0;
+    double mean_hops = 0, sampled_hops = 0;
+    for (size_t t = 1; t < pairs.size(); t++)
+        mean_hops += t * (pairs[t] - pairs[t - 1]);
+    for (size_t t = 1; t < sampled.size(); t++) {
+        sampled_connected += sampled[t];
+        sampled_hops += (double)t * sampled[t];
+    }
+    mean_hops /= max(connected, 1.0);
+    sampled_hops /= max(sampled_connected, 1LL);
+    double diameter = effectiveDiameter(pairs);
+    cout << "Mean separation " << mean_hops << " hops (" << sampled_hops
+         << " sampled), effective diameter " << diameter
+         << ", mean harmonic centrality error "
+         << 100 * harmonic_error / max(sources, 1) << "%" << endl;
+
+    out_file << "Connected pairs\t" << connected << '\n'
+             << "Mean hops\t" << mean_hops << '\n'
+             << "Sampled mean hops\t" << sampled_hops << '\n'
+             << "Effective diameter\t" << diameter << '\n'
+             << "Largest hops\t" << pairs.size() - 1 << '\n';
+    out_file << "\nHops\tPairs\tShare\tSampled share\n";
+    size_t largest = max(pairs.size(), sampled.size());
+    for (size_t t = 1; t < largest; t++) {
+        double within = t < pairs.size() ? pairs[t] - pairs[t - 1] : 0;
+        long long exact = t < sampled.size() ? sampled[t] : 0;
+        out_file << t << '\t' << within << '\t'
+                 << within / max(connected, 1.0) << '\t'
+                 << (double)exact / max(sampled_connected, 1LL) << '\n';
+    }
+    out_file << "\nActor\tReachable\tHarmonic\n";
+    for (int v = 0; v < num_actors; v++) {
+        out_file << actor_graph.actorName(v) << '\t'
+                 << function.reachable[v] << '\t' << function.harmonic[v]
+                 << '\n';
+    }
+    return 0;
+}
+
+
+/*
+ * Embeds every actor in d dimensions from the eigenvectors of the
+ * normalized co-star adjacency, and finds its eigenvector centrality (see
+ * spectral.hpp). Writes each actor's centrality and coordinates, and reports
+ * the eigenvalues found and the most central actors.
+ *
+ * Mode arguments:
+ *  args[0] - d
+ *      Optional dimensions of the embedding, 8 by default, under the number
+ *      of actors.
+ */
+static int RunEmbedding(const vector<string>& args, ofstream& out_file) {
+    int dims = 8;
+    if (!args.empty() && (!parseInt(args[0], dims) || dims <= 0)) {
+        cout << USAGE;
+        return -1;
+    }
+    // Skipping u_0 takes dims + 1 eigenvectors of the actors' matrix
+    int num_actors = actor_graph.numActors();
+    if (dims >= num_actors) {
+        cout << "Embedding needs fewer dimensions than the " << num_actors
+             << " actors (" << dims << ")!" << endl;
+        return -1;
+    }
+    auto start = chrono::steady_clock::now();
+    vector<double> eigenvalues;
+    bool converged;
+    vector<double> coordinates = spectralEmbedding(graph, dims, eigenvalues,
+                                                   converged);
+    chrono::duration<double> embed_time = chrono::steady_clock::now() - start;
+    if ((int)eigenvalues.size() < dims + 1) {
+        cout << "Found only " << eigenvalues.size() << " of " << dims + 1
+             << " eigenvectors, embed in at most " << eigenvalues.size() - 1
+             << " dimensions!" << endl;
+        return -1;
+    }
+    if (!converged) {
+        cout << "Lanczos did not converge, eigenvectors may be inexact ..."
+             << endl;
+    }
+    start = chrono::steady_clock::now();
+    double largest;
+    vector<double> centrality = eigenvectorCentrality(graph, largest);
+    chrono::duration<double> centrality_time = chrono::steady_clock::now() -
+                                               start;
+
+    cout << "Embedded actors in " << embed_time.count()
+         << "s, normalized eigenvalues";
+    for (double value : eigenvalues)
+        cout << ' ' << value;
+    cout << " ..." << endl;
+    cout << "Found eigenvector centrality in " << centrality_time.count()
+         << "s, largest eigenvalue " << largest << " ..." << endl;
+
+    vector<int> order(num_actors);
+    for (int v = 0; v < num_actors; v++)
+        order[v] = v;
+    int shown = min(5, num_actors);
+    partial_sort(order.begin(), order.begin() + shown, order.end(),
+                 [&](int x, int y) { return centrality[x] > centrality[y]; });
+    cout << "Most central:";
+    for (int i = 0; i < shown; i++)
+        cout << (i ? ", " : " ") << actor_graph.actorName(order[i]);
+    cout << endl;
+
+    out_file << "Actor\tCentrality";
+    for (int i = 1; i <= dims; i++)
+        out_file << "\tX" << i;
+    out_file << '\n';
+    for (int v = 0; v < num_actors; v++) {
+        out_file << actor_graph.actorName(v) << '\t' << centrality[v];
+        for (int i = 0; i < dims; i++)
+            out_file << '\t' << coordinates[(size_t)v * dims + i];
+        out_file << '\n';
+    }
+    return 0;
+}
+
+
+// Properties of a snapshot compared by the sparsify mode.
+struct SnapshotProperties {
+    double roles = 0;
+    double connections = 0;
+    double actors = 0;
+    double largest_component = 0;
+    double mean_hops = 0;
+    double effective_diameter = 0;
+    vector<string> most_central;
+};
+
+/*
+ * Measures the properties of a snapshot compared by the sparsify mode.
+ *
+ * Parameters:
+ *  g -
+ *      Loaded graph.
+ *  costars -
+ *      Co-star matrix of g.
+ *  central -
+ *      Number of most central actors listed.
+ */
+static SnapshotProperties MeasureSnapshot(const ActorGraph& g,
+                                          const CsrMatrix<char>& costars,
+                                          int central) {
+    SnapshotProperties p;
+    p.roles = g.numRoles();
+    p.connections = costars.nnz() / 2;
+    p.actors = g.numActors();
+    vector<int> sizes = ComponentSizes(g);
+    p.largest_component = sizes.empty() ? 0 : *max_element(sizes.begin(),
+                                                           sizes.end());
+    NeighborhoodFunction function = hyperAnf(g, 8);
+    double connected = function.pairs.back() - function.pairs[0];
+    for (size_t t = 1; t < function.pairs.size(); t++)
+        p.mean_hops += t * (function.pairs[t] - function.pairs[t - 1]);
+    p.mean_hops /= max(connected, 1.0);
+    p.effective_diameter = effectiveDiameter(function.pairs);
+
+    double largest;
+    vector<double> centrality = eigenvectorCentrality(costars, largest);
+    vector<int> order(g.numActors());
+    for (int v = 0; v < g.numActors(); v++)
+        order[v] = v;
+    int shown = min(central, g.numActors());
+    partial_sort(order.begin(), order.begin() + shown, order.end(),
+                 [&](int x, int y) { return centrality[x] > centrality[y]; });
+    for (int i = 0; i < shown; i++)
+        p.most_central.push_back(g.actorName(order[i]));
+    sort(p.most_central.begin(), p.most_central.end());
+    return p;
+}
+
+/*
+ * Writes a sparsified data.tsv, keeping the roles chosen by one of the
+ * sparsifiers (see sparsify.hpp), then reads it back and reports how far it
+ * strays from the full graph. Roles and connections kept are the gain; the
+ * actors kept, the actors of the largest component, the mean separation and
+ * effective diameter (estimated by HyperANF) and the 100 most central actors
+ * by eigenvector centrality are each checked against the tolerance, as the
+ * relative change or the share of the most central actors lost. While any
+ * is outside the tolerance, the amount is raised and the snapshot written
+ * again, so the cast cap doubles and the share or exponent halves its
+ * distance to 1, which keeps every role. The report of the snapshot kept is
+ * written to the output name followed by ".report".
+ *
+ * Mode arguments:
+ *  args[0] - method
+ *      cast, resistance or local.
+ *  args[1] - amount
+ *      Largest cast kept for cast, a whole number of at least 1. Expected
+ *      share of roles kept for resistance and exponent of the degree kept
+ *      for local, each in (0, 1].
+ *  args[2] - tolerance
+ *      Optional largest relative change of a property, 0.1 by default.
+ */
+static int RunSparsify(const vector<string>& args, ofstream& out_file) {
+    const int CENTRAL = 100;
+    SparsifyMethod method;
+    if (args[0] == "cast") {
+        method = CAST_SAMPLING;
+    } else if (args[0] == "resistance") {
+        method = RESISTANCE_SAMPLING;
+    } else if (args[0] == "local") {
+        method = LOCAL_DEGREE;
+    } else {
+        cout << "Unknown sparsifier (" << args[0] << ")" << endl;
+        return -1;
+    }
+    // A whole cast of at least one for cast, a share or exponent in (0, 1]
+    // otherwise
+    double amount, tolerance = 0.1;
+    int cast;
+    bool valid = method == CAST_SAMPLING
+                     ? parseInt(args[1], cast) && cast >= 1
+                     : parseDouble(args[1], amount) && amount > 0 &&
+                           amount <= 1;
+    if (method == CAST_SAMPLING)
+        amount = cast;
+    if (!valid || (args.size() > 2 && (!parseDouble(args[2], tolerance) ||
+                                       tolerance < 0))) {
+        cout << USAGE;
+        return -1;
+    }
+
+    // Largest amount, which keeps every role
+    double everything = 1;
+    if (method == CAST_SAMPLING) {
+        for (int m = 0; m < actor_graph.numMovies(); m++)
+            everything = max(everything,
+                             (double)actor_graph.castOf(m).size());
+        amount = min(amount, everything);
+    }
+    SnapshotProperties full = MeasureSnapshot(actor_graph, graph, CENTRAL);
+
+    // Raises the amount until every property is within the tolerance
+    while (true) {
+        // Rows of the kept roles, movies split back into title and year
+        vector<char> keep = sparsifyRoles(actor_graph, method, amount);
+        out_file.close();
+        out_file.open(output_name);
+        out_file << "Actor/Actress\tMovie\tYear\n";
+        for (int a = 0; a < actor_graph.numActors(); a++) {
+            int role = actor_graph.firstRole(a);
+            for (int m : actor_graph.moviesOf(a)) {
+                if (!keep[role++])
+                    continue;
+                const string& title = actor_graph.movieTitle(m);
+                size_t at = title.rfind("#@");
+                out_file << actor_graph.actorName(a) << '\t'
+                         << title.substr(0, at) << '\t'
+                         << title.substr(at + 2) << '\n';
+            }
+        }
+        out_file.flush();
+
+        ActorGraph sparse;
+        if (!out_file || !sparse.loadFromFile(output_name.c_str(), false)) {
+            cout << "Failed to read back the sparsified graph!\n";
+            return -1;
+        }
+        CsrMatrix<char> sparse_costars = coStarMatrix(sparse);
+        cout << "Kept " << sparse.numRoles() << " of "
+             << actor_graph.numRoles() << " roles, "
+             << sparse_costars.nnz() / 2 << " of " << graph.nnz() / 2
+             << " connections with " << args[0] << " " << amount << " ..."
+             << endl;
+
+        SnapshotProperties part = MeasureSnapshot(sparse, sparse_costars,
+                                                  CENTRAL);
+        vector<string> shared;
+        set_intersection(full.most_central.begin(), full.most_central.end(),
+                         part.most_central.begin(), part.most_central.end(),
+                         back_inserter(shared));
+
+        ofstream report(output_name + ".report");
+        report << "Property\tFull\tSparsified\tChange\tWithin " << tolerance
+               << '\n';
+        int within = 0, checked = 0;
+        auto row = [&](const string& name, double before, double after,
+                       bool check) {
+            double change = before ? (after - before) / before : 0;
+            report << name << '\t' << before << '\t' << after << '\t'
+                   << change << '\t';
+            if (check) {
+                bool ok = fabs(change) <= tolerance;
+                report << (ok ? "yes" : "no");
+                within += ok;
+                checked++;
+            }
+            report << '\n';
+        };
+        row("Roles", full.roles, part.roles, false);
+        row("Connections", full.connections, part.connections, false);
+        row("Actors", full.actors, part.actors, true);
+        row("Largest component", full.largest_component,
+            part.largest_component, true);
+        row("Mean hops", full.mean_hops, part.mean_hops, true);
+        row("Effective diameter", full.effective_diameter,
+            part.effective_diameter, true);
+        row("Most central actors", full.most_central.size(), shared.size(),
+            true);
+        cout << within << " of " << checked << " properties within tolerance "
+             << tolerance << ", see " << output_name << ".report" << endl;
+        if (within == checked)
+            return 0;
+        if (amount >= everything) {
+            cout << "No amount keeps every property within tolerance "
+                 << tolerance << "!" << endl;
+            return -1;
+        }
+
+        // Casts double, shares and exponents halve their distance to 1
+        if (method == CAST_SAMPLING)
+            amount = min(2 * amount, everything);
+        else
+            amount = 1 - amount < 0.02 ? 1 : (1 + amount) / 2;
+    }
+}
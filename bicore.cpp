@@ -0,0 +1,282 @@
+/*
+ * This file implements the (alpha, beta)-core peeling and index of the
+ * bipartite graph of actors and movies. See bicore.hpp.
+ */
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+#include "actorgraph.hpp"
+#include "bicore.hpp"
+#include "parallel.hpp"
+#include "trace.hpp"
+
+using namespace std;
+
+
+/*
+ * Peels the (alpha, beta)-core of graph, in time linear in its roles.
+ *
+ * Parameters:
+ *  graph -
+ *      Loaded graph.
+ *  alpha -
+ *      Movies each actor of the core is cast in, at least.
+ *  beta -
+ *      Actors each movie of the core casts, at least.
+ *
+ * Returns:
+ *  BiCore -
+ *      Actors and movies of the core, in increasing id order.
+ */
+BiCore peelBiCore(const ActorGraph& graph, int alpha, int beta) {
+    int num_actors = graph.numActors();
+    int num_movies = graph.numMovies();
+
+    // Movies and cast left of every actor and movie, -1 once peeled
+    vector<int> actor_degree(num_actors);
+    vector<int> movie_degree(num_movies);
+    vector<int> actor_stack, movie_stack;
+    for (int a = 0; a < num_actors; a++) {
+        actor_degree[a] = graph.moviesOf(a).size();
+        if (actor_degree[a] < alpha)
+            actor_stack.push_back(a);
+    }
+    for (int m = 0; m < num_movies; m++) {
+        movie_degree[m] = graph.castOf(m).size();
+        if (movie_degree[m] < beta)
+            movie_stack.push_back(m);
+    }
+
+    // Peel until neither side has a vertex under its threshold
+    while (!actor_stack.empty() || !movie_stack.empty()) {
+        while (!actor_stack.empty()) {
+            int a = actor_stack.back();
+            actor_stack.pop_back();
+            actor_degree[a] = -1;
+            for (int m : graph.moviesOf(a)) {
+                if (movie_degree[m]-- == beta)
+                    movie_stack.push_back(m);
+            }
+        }
+        while (!movie_stack.empty()) {
+            int m = movie_stack.back();
+            movie_stack.pop_back();
+            movie_degree[m] = -1;
+            for (int a : graph.castOf(m)) {
+                if (actor_degree[a]-- == alpha)
+                    actor_stack.push_back(a);
+            }
+        }
+    }
+
+    BiCore core;
+    for (int a = 0; a < num_actors; a++) {
+        if (actor_degree[a] >= 0)
+            core.actors.push_back(a);
+    }
+    for (int m = 0; m < num_movies; m++) {
+        if (movie_degree[m] >= 0)
+            core.movies.push_back(m);
+    }
+    return core;
+}
+
+
+/*
+ * Finds, for a threshold k on one side of the graph, the largest threshold
+ * of the other side of a core holding each vertex: with the fixed side held
+ * to k, the peeled side is peeled by increasing degree, the level rising to
+ * each degree peeled, and a fixed vertex falling under k is peeled at the
+ * current level. Buckets of vertices by degree make the peel linear.
+ *
+ * Parameters:
+ *  k -
+ *      Threshold of the fixed side.
+ *  num_fixed, num_peeled -
+ *      Vertices of each side.
+ *  fixed_neighbors, peeled_neighbors -
+ *      Neighbors of a vertex of each side, on the other side.
+ *  fixed_limits, peeled_limits -
+ *      Receive the largest threshold of the peeled side of a core holding
+ *      each vertex, 0 if none.
+ */
+static void PeelLevel(int k, int num_fixed, int num_peeled,
+                      const function<IdRange(int)>& fixed_neighbors,
+                      const function<IdRange(int)>& peeled_neighbors,
+                      vector<int>& fixed_limits, vector<int>& peeled_limits) {
+    vector<int> fixed_degree(num_fixed);
+    vector<int> peeled_degree(num_peeled);
+    vector<vector<int>> buckets(1);
+    fixed_limits.assign(num_fixed, 0);
+    peeled_limits.assign(num_peeled, 0);
+    for (int y = 0; y < num_peeled; y++) {
+        peeled_degree[y] = peeled_neighbors(y).size();
+        if (peeled_degree[y] >= (int)buckets.size())
+            buckets.resize(peeled_degree[y] + 1);
+        buckets[peeled_degree[y]].push_back(y);
+    }
+
+    // Peels fixed vertex x at level, moving its neighbors down to their
+    // degree, or the level if above
+    int level = 0;
+    auto peel_fixed = [&](int x) {
+        fixed_degree[x] = -1;
+        fixed_limits[x] = level;
+        for (int y : fixed_neighbors(x)) {
+            if (peeled_degree[y] >= 0)
+                buckets[max(--peeled_degree[y], level)].push_back(y);
+        }
+    };
+    for (int x = 0; x < num_fixed; x++)
+        fixed_degree[x] = fixed_neighbors(x).size();
+    for (int x = 0; x < num_fixed; x++) {
+        if (fixed_degree[x] < k)
+            peel_fixed(x);
+    }
+
+    // A bucket holds stale entries of vertices since moved lower or peeled
+    for (; level < (int)buckets.size(); level++) {
+        vector<int>& bucket = buckets[level];
+        while (!bucket.empty()) {
+            int y = bucket.back();
+            bucket.pop_back();
+            if (peeled_degree[y] < 0 || peeled_degree[y] > level)
+                continue;
+            peeled_degree[y] = -1;
+            peeled_limits[y] = level;
+            for (int x : peeled_neighbors(y)) {
+                if (fixed_degree[x] >= 0 && --fixed_degree[x] < k)
+                    peel_fixed(x);
+            }
+        }
+    }
+}
+
+
+/*
+ * Keeps the vertices of limit at least 1 of a side in a level, by decreasing
+ * limit then id.
+ */
+static void KeepLimits(const vector<int>& limits, vector<int>& ids,
+                       vector<int>& kept) {
+    for (int v = 0; v < (int)limits.size(); v++) {
+        if (limits[v] > 0)
+            ids.push_back(v);
+    }
+    stable_sort(ids.begin(), ids.end(), [&](int x, int y) {
+        return limits[x] > limits[y];
+    });
+    kept.reserve(ids.size());
+    for (int v : ids)
+        kept.push_back(limits[v]);
+}
+
+
+/*
+ * Builds the index for graph using numThreads() threads. Delta is found by
+ * binary search over peeled (k, k)-cores, then each level is a peel.
+ *
+ * Parameters:
+ *  graph -
+ *      Loaded graph.
+ */
+void BiCoreIndex::build(const ActorGraph& graph) {
+    TRACE_SCOPE("bicore index");
+    int lo = 0, hi = 1;
+    while (!peelBiCore(graph, hi, hi).actors.empty()) {
+        lo = hi;
+        hi *= 2;
+    }
+    while (hi - lo > 1) {
+        int mid = (lo + hi) / 2;
+        if (peelBiCore(graph, mid, mid).actors.empty())
+            hi = mid;
+        else
+            lo = mid;
+    }
+    delta = lo;
+
+    auto movies_of = [&](int a) { return graph.moviesOf(a); };
+    auto cast_of = [&](int m) { return graph.castOf(m); };
+    alpha_levels.assign(delta, Level());
+    beta_levels.assign(delta, Level());
+    parallelFor(0, 2 * delta, 1, [&](int first, int last, int) {
+        vector<int> actor_limits, movie_limits;
+        for (int i = first; i < last; i++) {
+            int k = i % delta + 1;
+            Level& level = i < delta ? alpha_levels[k - 1]
+                                     : beta_levels[k - 1];
+            if (i < delta) {
+                PeelLevel(k, graph.numActors(), graph.numMovies(), movies_of,
+                          cast_of, actor_limits, movie_limits);
+            } else {
+                PeelLevel(k, graph.numMovies(), graph.numActors(), cast_of,
+                          movies_of, movie_limits, actor_limits);
+            }
+            KeepLimits(actor_limits, level.actors, level.actor_limits);
+            KeepLimits(movie_limits, level.movies, level.movie_limits);
+        }
+    });
+}
+
+
+// Largest beta of a non-empty (alpha, beta)-core, 0 if none.
+int BiCoreIndex::maxBeta(int alpha) const {
+    alpha = max(alpha, 1);
+    if (alpha <= delta)
+        return alpha_levels[alpha - 1].actor_limits[0];
+    for (int beta = delta; beta >= 1; beta--) {
+        if (maxAlpha(beta) >= alpha)
+            return beta;
+    }
+    return 0;
+}
+
+
+// Largest alpha of a non-empty (alpha, beta)-core, 0 if none.
+int BiCoreIndex::maxAlpha(int beta) const {
+    beta = max(beta, 1);
+    if (beta <= delta)
+        return beta_levels[beta - 1].movie_limits[0];
+    for (int alpha = delta; alpha >= 1; alpha--) {
+        if (maxBeta(alpha) >= beta)
+            return alpha;
+    }
+    return 0;
+}
+
+
+/*
+ * Finds an (alpha, beta)-core from the level of the smaller parameter, as
+ * the prefix of its vertices whose limit reaches the other parameter.
+ *
+ * Parameters:
+ *  alpha -
+ *      Movies each actor of the core is cast in, at least.
+ *  beta -
+ *      Actors each movie of the core casts, at least.
+ *
+ * Returns:
+ *  BiCore -
+ *      Actors and movies of the core, in no particular order.
+ */
+BiCore BiCoreIndex::query(int alpha, int beta) const {
+    alpha = max(alpha, 1);
+    beta = max(beta, 1);
+    BiCore core;
+    if (min(alpha, beta) > delta)
+        return core;
+    const Level& level = alpha <= beta ? alpha_levels[alpha - 1]
+                                       : beta_levels[beta - 1];
+    int other = alpha <= beta ? beta : alpha;
+    auto reaching = [&](const vector<int>& limits) {
+        return upper_bound(limits.begin(), limits.end(), other,
+                           greater<int>()) - limits.begin();
+    };
+    core.actors.assign(level.actors.begin(),
+                       level.actors.begin() + reaching(level.actor_limits));
+    core.movies.assign(level.movies.begin(),
+                       level.movies.begin() + reaching(level.movie_limits));
+    return core;
+}
@@ -0,0 +1,122 @@
+/*
+ * This file declares the (alpha, beta)-cores of the bipartite graph of actors
+ * and movies: the largest set of actors and movies in which every actor is
+ * cast in at least alpha of the movies and every movie casts at least beta
+ * of the actors. Where the k-core of popularityfinder needs the co-star
+ * projection, whose large casts become quadratically many links, a core is
+ * peeled from the roles themselves, in time linear in the roles.
+ *
+ *  peelBiCore  - one (alpha, beta)-core, by peeling actors with fewer than
+ *                alpha movies and movies with fewer than beta actors left.
+ *  BiCoreIndex - every (alpha, beta)-core at once (Liu et al., "Efficient
+ *                (alpha, beta)-core Computation: an Index-based Approach",
+ *                WWW 2019).
+ *
+ * No core has both alpha and beta above delta, the largest k with a
+ * non-empty (k, k)-core. The index thus keeps, for each alpha up to delta,
+ * the actors and movies of the (alpha, 1)-core with the largest beta of a
+ * core they are in, ordered by it, and the same for each beta up to delta
+ * with alpha. A core is the prefix of the list of its smaller parameter
+ * whose largest other parameter reaches the larger, found by binary search.
+ * Each list is one linear peel, and the lists are built in parallel.
+ */
+
+#ifndef BICORE_HPP
+#define BICORE_HPP
+
+#include <vector>
+#include "actorgraph.hpp"
+#include "memory.hpp"
+
+using namespace std;
+
+// Actors and movies of an (alpha, beta)-core.
+struct BiCore {
+    vector<int> actors;
+    vector<int> movies;
+};
+
+/*
+ * Peels the (alpha, beta)-core of graph, in time linear in its roles.
+ *
+ * Parameters:
+ *  graph -
+ *      Loaded graph.
+ *  alpha -
+ *      Movies each actor of the core is cast in, at least.
+ *  beta -
+ *      Actors each movie of the core casts, at least.
+ *
+ * Returns:
+ *  BiCore -
+ *      Actors and movies of the core, in increasing id order.
+ */
+BiCore peelBiCore(const ActorGraph& graph, int alpha, int beta);
+
+class BiCoreIndex {
+private:
+    // Vertices of an (alpha, 1)-core by decreasing largest beta of a core
+    // they are in, with those betas, or the same with alpha and beta swapped.
+    struct Level {
+        vector<int> actors;
+        vector<int> actor_limits;
+        vector<int> movies;
+        vector<int> movie_limits;
+    };
+
+    // Largest k with a non-empty (k, k)-core
+    int delta = 0;
+
+    // Levels of alpha and of beta from 1 to delta, at [alpha - 1]
+    vector<Level> alpha_levels;
+    vector<Level> beta_levels;
+
+public:
+    /*
+     * Builds the index for graph using numThreads() threads.
+     *
+     * Parameters:
+     *  graph -
+     *      Loaded graph.
+     */
+    void build(const ActorGraph& graph);
+
+    // Largest k with a non-empty (k, k)-core.
+    int degeneracy() const { return delta; }
+
+    // Largest beta of a non-empty (alpha, beta)-core, 0 if none.
+    int maxBeta(int alpha) const;
+
+    // Largest alpha of a non-empty (alpha, beta)-core, 0 if none.
+    int maxAlpha(int beta) const;
+
+    /*
+     * Finds an (alpha, beta)-core, in time linear in its size.
+     *
+     * Parameters:
+     *  alpha -
+     *      Movies each actor of the core is cast in, at least.
+     *  beta -
+     *      Actors each movie of the core casts, at least.
+     *
+     * Returns:
+     *  BiCore -
+     *      Actors and movies of the core, in no particular order.
+     */
+    BiCore query(int alpha, int beta) const;
+
+    // Bytes held by the index, by capacity.
+    size_t bytes() const {
+        size_t sum = (alpha_levels.capacity() + beta_levels.capacity()) *
+                     sizeof(Level);
+        for (const vector<Level>* levels : {&alpha_levels, &beta_levels}) {
+            for (const Level& l : *levels) {
+                sum += memoryBytes(l.actors) + memoryBytes(l.actor_limits) +
+                       memoryBytes(l.movies) + memoryBytes(l.movie_limits);
+            }
+        }
+        return sum;
+    }
+};
+
+#endif  // BICORE_HPP
@@ -0,0 +1,137 @@
+/*
+ * This file contains BoundedQueue, a blocking queue of fixed capacity joining
+ * the stages of a pipeline. A producer pushing to a full queue waits until a
+ * consumer makes room, so a slow stage holds back the stages feeding it and
+ * memory stays bounded by the capacities. The queue keeps the statistics
+ * needed to find the bottleneck stage: its mean and largest depth, and how
+ * long producers waited on it being full and consumers on it being empty.
+ */
+
+#ifndef BOUNDEDQUEUE_HPP
+#define BOUNDEDQUEUE_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include "trace.hpp"
+
+using namespace std;
+
+// Statistics of a BoundedQueue over its lifetime.
+struct QueueStats {
+    double mean_depth = 0;  // depth averaged over time
+    int max_depth = 0;
+    double push_wait = 0;   // seconds producers waited on a full queue
+    double pop_wait = 0;    // seconds consumers waited on an empty queue
+};
+
+template <class T>
+class BoundedQueue {
+private:
+    typedef chrono::steady_clock Clock;
+
+    mutex lock;
+    condition_variable not_full;
+    condition_variable not_empty;
+    deque<T> items;
+    size_t capacity;
+    bool closed = false;
+
+    // Depth integrated over time, and when it last changed
+    Clock::time_point created = Clock::now();
+    Clock::time_point changed = created;
+    double depth_time = 0;
+    QueueStats stats;
+
+    // Accounts the time spent at the current depth. Requires lock held.
+    void noteDepth() {
+        Clock::time_point now = Clock::now();
+        depth_time += items.size() *
+                      chrono::duration<double>(now - changed).count();
+        changed = now;
+        stats.max_depth = max(stats.max_depth, (int)items.size());
+    }
+
+public:
+    // Queue holding at most capacity items, at least one.
+    explicit BoundedQueue(size_t capacity) : capacity(max((size_t)1,
+                                                          capacity)) {}
+
+    /*
+     * Appends item, waiting while the queue is full.
+     *
+     * Returns:
+     *  bool -
+     *      False if the queue was closed, the item being dropped.
+     */
+    bool push(T item) {
+        unique_lock<mutex> guard(lock);
+        if (items.size() >= capacity && !closed) {
+            TRACE_SCOPE("queue full");
+            Clock::time_point start = Clock::now();
+            not_full.wait(guard, [this] {
+                return items.size() < capacity || closed;
+            });
+            stats.push_wait +=
+                chrono::duration<double>(Clock::now() - start).count();
+        }
+        if (closed)
+            return false;
+        noteDepth();
+        items.push_back(move(item));
+        guard.unlock();
+        not_empty.notify_one();
+        return true;
+    }
+
+    /*
+     * Removes the oldest item into item, waiting while the queue is empty
+     * and open.
+     *
+     * Returns:
+     *  bool -
+     *      False once the queue is closed and empty.
+     */
+    bool pop(T& item) {
+        unique_lock<mutex> guard(lock);
+        if (items.empty() && !closed) {
+            TRACE_SCOPE("queue empty");
+            Clock::time_point start = Clock::now();
+            not_empty.wait(guard, [this] { return !items.empty() || closed; });
+            stats.pop_wait +=
+                chrono::duration<double>(Clock::now() - start).count();
+        }
+        if (items.empty())
+            return false;
+        noteDepth();
+        item = move(items.front());
+        items.pop_front();
+        guard.unlock();
+        not_full.notify_one();
+        return true;
+    }
+
+    // Ends the queue: pushes fail, and pops fail once it is drained.
+    void close() {
+        {
+            lock_guard<mutex> guard(lock);
+            closed = true;
+        }
+        not_full.notify_all();
+        not_empty.notify_all();
+    }
+
+    // Statistics so far.
+    QueueStats statistics() {
+        lock_guard<mutex> guard(lock);
+        noteDepth();
+        QueueStats s = stats;
+        double lifetime = chrono::duration<double>(changed - created).count();
+        s.mean_depth = lifetime > 0 ? depth_time / lifetime : 0;
+        return s;
+    }
+};
+
+#endif  // BOUNDEDQUEUE_HPP
@@ -0,0 +1,345 @@
+/*
+ * This file implements the butterfly kernels over the bipartite graph of
+ * actors and movies. See butterfly.hpp.
+ */
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+#include "actorgraph.hpp"
+#include "butterfly.hpp"
+#include "parallel.hpp"
+#include "trace.hpp"
+
+using namespace std;
+
+// Min-heap of (butterflies, id) entries, stale once the count changes
+typedef priority_queue<pair<long long, int>, vector<pair<long long, int>>,
+                       greater<pair<long long, int>>> PeelHeap;
+
+// Butterflies formed by c wedges between the same two vertices.
+static long long Pairs(long long c) { return c * (c - 1) / 2; }
+
+
+/*
+ * Neighbors of vertex x, numbering actors first and movies after them:
+ * movies for an actor, the cast for a movie.
+ *
+ * Parameters:
+ *  graph -
+ *      Loaded graph.
+ *  x -
+ *      Vertex, an actor id below numActors(), or numActors() plus a movie id.
+ *  offset -
+ *      Receives what to add to the ids of the range to make them vertices.
+ */
+static IdRange Neighbors(const ActorGraph& graph, int x, int& offset) {
+    int num_actors = graph.numActors();
+    if (x < num_actors) {
+        offset = num_actors;
+        return graph.moviesOf(x);
+    }
+    offset = 0;
+    return graph.castOf(x - num_actors);
+}
+
+
+/*
+ * Counts the butterflies of graph by vertex priority: vertices are ranked by
+ * degree, and each butterfly counted from its top ranked vertex u, as a pair
+ * of wedges u - v - w whose middle v and far end w rank below u.
+ *
+ * Parameters:
+ *  graph -
+ *      Loaded graph.
+ *
+ * Returns:
+ *  ButterflyCounts -
+ *      Total butterflies, and those through each actor and movie by id.
+ */
+ButterflyCounts countButterflies(const ActorGraph& graph) {
+    TRACE_SCOPE("butterflies");
+    int num_actors = graph.numActors();
+    int n = num_actors + graph.numMovies();
+
+    // Rank vertices by increasing degree, then id
+    vector<int> order(n);
+    vector<int> rank(n);
+    int offset;
+    for (int x = 0; x < n; x++)
+        order[x] = x;
+    sort(order.begin(), order.end(), [&](int x, int y) {
+        int dx = Neighbors(graph, x, offset).size();
+        int dy = Neighbors(graph, y, offset).size();
+        return dx != dy ? dx < dy : x < y;
+    });
+    for (int i = 0; i < n; i++)
+        rank[order[i]] = i;
+
+    // Wedges to each far end and butterflies through each vertex, per thread
+    int threads = numThreads();
+    vector<vector<int>> wedges(threads);
+    vector<vector<long long>> through(threads);
+    vector<long long> totals(threads, 0);
+    parallelFor(0, n, 64, [&](int lo, int hi, int t) {
+        vector<int>& wedge = wedges[t];
+        vector<long long>& count = through[t];
+        if (wedge.empty()) {
+            wedge.assign(n, 0);
+            count.assign(n, 0);
+        }
+        vector<int> touched;
+        for (int u = lo; u < hi; u++) {
+            int v_offset, w_offset;
+            for (int v : Neighbors(graph, u, v_offset)) {
+                v += v_offset;
+                if (rank[v] >= rank[u])
+                    continue;
+                for (int w : Neighbors(graph, v, w_offset)) {
+                    w += w_offset;
+                    if (rank[w] < rank[u] && wedge[w]++ == 0)
+                        touched.push_back(w);
+                }
+            }
+            // Pairs of wedges to the same far end are butterflies, through
+            // u, the far end and each middle
+            for (int w : touched) {
+                long long b = Pairs(wedge[w]);
+                totals[t] += b;
+                count[u] += b;
+                count[w] += b;
+            }
+            for (int v : Neighbors(graph, u, v_offset)) {
+                v += v_offset;
+                if (rank[v] >= rank[u])
+                    continue;
+                for (int w : Neighbors(graph, v, w_offset)) {
+                    w += w_offset;
+                    if (rank[w] < rank[u])
+                        count[v] += wedge[w] - 1;
+                }
+            }
+            for (int w : touched)
+                wedge[w] = 0;
+            touched.clear();
+        }
+    });
+
+    ButterflyCounts counts;
+    counts.actors.assign(num_actors, 0);
+    counts.movies.assign(graph.numMovies(), 0);
+    for (int t = 0; t < threads; t++) {
+        counts.total += totals[t];
+        for (int x = 0; !through[t].empty() && x < n; x++) {
+            if (x < num_actors)
+                counts.actors[x] += through[t][x];
+            else
+                counts.movies[x - num_actors] += through[t][x];
+        }
+    }
+    return counts;
+}
+
+
+/*
+ * Counts the butterflies through each role. A role of actor u in movie m is
+ * in a butterfly with every co-star w of m and every other movie u and w
+ * share, so its butterflies are the sum over the co-stars w of m of the
+ * movies u and w share less one.
+ *
+ * Parameters:
+ *  graph -
+ *      Loaded graph.
+ *
+ * Returns:
+ *  vector -
+ *      Butterflies through each role, by role id.
+ */
+vector<long long> roleButterflies(const ActorGraph& graph) {
+    TRACE_SCOPE("role butterflies");
+    int num_actors = graph.numActors();
+    vector<long long> butterflies(graph.numRoles(), 0);
+    vector<vector<int>> shared(numThreads());
+    parallelFor(0, num_actors, 64, [&](int lo, int hi, int t) {
+        vector<int>& common = shared[t];
+        if (common.empty())
+            common.assign(num_actors, 0);
+        for (int u = lo; u < hi; u++) {
+            for (int m : graph.moviesOf(u)) {
+                for (int w : graph.castOf(m))
+                    common[w] += w != u;
+            }
+            int role = graph.firstRole(u);
+            for (int m : graph.moviesOf(u)) {
+                long long b = 0;
+                for (int w : graph.castOf(m)) {
+                    if (w != u)
+                        b += common[w] - 1;
+                }
+                butterflies[role++] = b;
+            }
+            for (int m : graph.moviesOf(u)) {
+                for (int w : graph.castOf(m))
+                    common[w] = 0;
+            }
+        }
+    });
+    return butterflies;
+}
+
+
+/*
+ * Finds the tip number of every actor. The actor in fewest butterflies among
+ * the remaining actors is peeled with that count, or the largest count
+ * peeled so far if greater, and every remaining actor sharing c of its
+ * movies loses the c(c - 1) / 2 butterflies they formed.
+ *
+ * Parameters:
+ *  graph -
+ *      Loaded graph.
+ *  butterflies -
+ *      Butterflies through each actor, from countButterflies.
+ *
+ * Returns:
+ *  vector -
+ *      Tip number of each actor by id.
+ */
+vector<long long> tipDecomposition(const ActorGraph& graph,
+                                   const vector<long long>& butterflies) {
+    TRACE_SCOPE("tip decomposition");
+    int num_actors = graph.numActors();
+    vector<long long> count(butterflies);
+    vector<long long> tip(num_actors, 0);
+    vector<char> peeled(num_actors, 0);
+    vector<int> common(num_actors, 0);
+    vector<int> touched;
+    PeelHeap heap;
+    for (int u = 0; u < num_actors; u++)
+        heap.push(pair<long long, int>(count[u], u));
+
+    long long level = 0;
+    while (!heap.empty()) {
+        pair<long long, int> top = heap.top();
+        heap.pop();
+        int u = top.second;
+        if (peeled[u] || top.first != count[u])
+            continue;
+        level = max(level, count[u]);
+        tip[u] = level;
+        peeled[u] = 1;
+
+        for (int m : graph.moviesOf(u)) {
+            for (int w : graph.castOf(m)) {
+                if (!peeled[w] && common[w]++ == 0)
+                    touched.push_back(w);
+            }
+        }
+        for (int w : touched) {
+            if (common[w] >= 2) {
+                count[w] -= Pairs(common[w]);
+                heap.push(pair<long long, int>(count[w], w));
+            }
+            common[w] = 0;
+        }
+        touched.clear();
+    }
+    return tip;
+}
+
+
+/*
+ * Finds the wing number of every role. The role in fewest butterflies among
+ * the remaining roles is peeled with that count, or the largest count peeled
+ * so far if greater, and the other three roles of each of its remaining
+ * butterflies lose one.
+ *
+ * Parameters:
+ *  graph -
+ *      Loaded graph.
+ *  butterflies -
+ *      Butterflies through each role, from roleButterflies.
+ *
+ * Returns:
+ *  vector -
+ *      Wing number of each role by role id.
+ */
+vector<long long> wingDecomposition(const ActorGraph& graph,
+                                    const vector<long long>& butterflies) {
+    TRACE_SCOPE("wing decomposition");
+    int num_actors = graph.numActors();
+    int num_movies = graph.numMovies();
+    int num_roles = graph.numRoles();
+
+    // Actor and movie of each role, and the roles of each movie
+    vector<int> role_actor(num_roles);
+    vector<int> role_movie(num_roles);
+    vector<int> cast_offsets(num_movies + 1, 0);
+    for (int a = 0; a < num_actors; a++) {
+        int role = graph.firstRole(a);
+        for (int m : graph.moviesOf(a)) {
+            role_actor[role] = a;
+            role_movie[role++] = m;
+            cast_offsets[m + 1]++;
+        }
+    }
+    for (int m = 0; m < num_movies; m++)
+        cast_offsets[m + 1] += cast_offsets[m];
+    vector<int> cast_roles(num_roles);
+    vector<int> fill(cast_offsets.begin(), cast_offsets.end() - 1);
+    for (int r = 0; r < num_roles; r++)
+        cast_roles[fill[role_movie[r]]++] = r;
+
+    vector<long long> count(butterflies);
+    vector<long long> wing(num_roles, 0);
+    vector<char> peeled(num_roles, 0);
+    // Role of the peeled role's actor in each movie, -1 if none remains
+    vector<int> role_in(num_movies, -1);
+    PeelHeap heap;
+    for (int r = 0; r < num_roles; r++)
+        heap.push(pair<long long, int>(count[r], r));
+    auto lose = [&](int r) {
+        count[r]--;
+        heap.push(pair<long long, int>(count[r], r));
+    };
+
+    long long level = 0;
+    while (!heap.empty()) {
+        pair<long long, int> top = heap.top();
+        heap.pop();
+        int e = top.second;
+        if (peeled[e] || top.first != count[e])
+            continue;
+        level = max(level, count[e]);
+        wing[e] = level;
+        peeled[e] = 1;
+
+        // Butterflies of u in m with w in m, sharing another movie m2
+        int u = role_actor[e];
+        int m = role_movie[e];
+        int u_end = graph.firstRole(u) + graph.moviesOf(u).size();
+        for (int r = graph.firstRole(u); r < u_end; r++) {
+            if (!peeled[r])
+                role_in[role_movie[r]] = r;
+        }
+        for (int i = cast_offsets[m]; i < cast_offsets[m + 1]; i++) {
+            int f = cast_roles[i];
+            int w = role_actor[f];
+            if (peeled[f] || w == u)
+                continue;
+            int w_end = graph.firstRole(w) + graph.moviesOf(w).size();
+            for (int g = graph.firstRole(w); g < w_end; g++) {
+                int h = peeled[g] ? -1 : role_in[role_movie[g]];
+                if (h < 0)
+                    continue;
+                lose(h);
+                lose(f);
+                lose(g);
+            }
+        }
+        for (int r = graph.firstRole(u); r < u_end; r++)
+            role_in[role_movie[r]] = -1;
+    }
+    return wing;
+}
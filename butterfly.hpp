@@ -0,0 +1,111 @@
+/*
+ * This file declares the butterfly kernels, which find cohesive groups in the
+ * bipartite graph of actors and movies itself rather than in its projection
+ * onto actors. A butterfly is two actors who share two movies, a 2 x 2
+ * biclique, the smallest cohesive unit of a bipartite graph as the triangle
+ * is of an ordinary one. Unlike the co-star projection, where a cast of c
+ * actors becomes c(c - 1) / 2 links, butterflies only reward actors who work
+ * together again and again.
+ *
+ *  countButterflies  - butterflies in total and through each actor and
+ *                      movie, by vertex priority counting (Wang et al.,
+ *                      "Vertex Priority Based Butterfly Counting for
+ *                      Large-scale Bipartite Networks", VLDB 2019).
+ *  roleButterflies   - butterflies through each role, the link of an actor
+ *                      to a movie.
+ *  tipDecomposition  - the tip number of each actor: the largest k such that
+ *                      the actor is in a group of actors each in at least k
+ *                      butterflies within the group (Sariyuce and Pinar,
+ *                      "Peeling Bipartite Networks for Dense Subgraph
+ *                      Discovery", WSDM 2018).
+ *  wingDecomposition - the wing number of each role, the same over roles.
+ *
+ * Vertex priority counting ranks actors and movies together by degree, and
+ * counts each butterfly once, from its vertex of highest rank, through
+ * wedges whose other vertices rank lower. Wedges are thus walked from the
+ * low degree end, bounding the work by the sum over roles of the smaller
+ * degree of their two ends rather than the sum of squared degrees. Counts
+ * are spread over numThreads() threads. Decompositions peel the actor or
+ * role in fewest butterflies, updating the counts of those sharing its
+ * butterflies, and are sequential.
+ *
+ * Each actor is assumed listed at most once per movie.
+ */
+
+#ifndef BUTTERFLY_HPP
+#define BUTTERFLY_HPP
+
+#include <vector>
+#include "actorgraph.hpp"
+
+using namespace std;
+
+// Butterflies of a graph in total and through each actor and movie.
+struct ButterflyCounts {
+    long long total = 0;
+    vector<long long> actors;
+    vector<long long> movies;
+};
+
+/*
+ * Counts the butterflies of graph with numThreads() threads.
+ *
+ * Parameters:
+ *  graph -
+ *      Loaded graph.
+ *
+ * Returns:
+ *  ButterflyCounts -
+ *      Total butterflies, and those through each actor and movie by id.
+ */
+ButterflyCounts countButterflies(const ActorGraph& graph);
+
+/*
+ * Counts the butterflies through each role of graph with numThreads()
+ * threads.
+ *
+ * Parameters:
+ *  graph -
+ *      Loaded graph.
+ *
+ * Returns:
+ *  vector -
+ *      Butterflies through each role, by role id (see ActorGraph firstRole).
+ */
+vector<long long> roleButterflies(const ActorGraph& graph);
+
+/*
+ * Finds the tip number of every actor by peeling actors in order of their
+ * butterflies among the actors not yet peeled.
+ *
+ * Parameters:
+ *  graph -
+ *      Loaded graph.
+ *  butterflies -
+ *      Butterflies through each actor, from countButterflies.
+ *
+ * Returns:
+ *  vector -
+ *      Tip number of each actor by id.
+ */
+vector<long long> tipDecomposition(const ActorGraph& graph,
+                                   const vector<long long>& butterflies);
+
+/*
+ * Finds the wing number of every role by peeling roles in order of their
+ * butterflies among the roles not yet peeled.
+ *
+ * Parameters:
+ *  graph -
+ *      Loaded graph.
+ *  butterflies -
+ *      Butterflies through each role, from roleButterflies.
+ *
+ * Returns:
+ *  vector -
+ *      Wing number of each role by role id.
+ */
+vector<long long> wingDecomposition(const ActorGraph& graph,
+                                    const vector<long long>& butterflies);
+
+#endif  // BUTTERFLY_HPP
@@ -0,0 +1,161 @@
+/*
+ * This file contains the checkpointing of batch jobs, which let a preempted
+ * run resume where it stopped. A batch writes its results in input order to
+ * an output file; after each chunk of inputs it flushes the output and
+ * records how many inputs are done and how long the output was at that
+ * moment in a checkpoint file beside it, output name plus ".ckpt". To resume,
+ * the output is cut back to the recorded length and the batch continues after
+ * the recorded inputs, so the finished output is identical to that of an
+ * uninterrupted run.
+ *
+ * Checkpoints are written to a temporary file and renamed over the previous
+ * one, so a run stopped mid write leaves the last complete checkpoint. Each
+ * records the sizes of the input and graph files and the settings the
+ * results depend on, such as the mode and weighting, and a run with any of
+ * them changed refuses to resume rather than append different results.
+ */
+
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include "trace.hpp"
+
+using namespace std;
+
+class Checkpoint {
+private:
+    // Name of the checkpoint file, sizes of the input and graph files in
+    // bytes, and settings of the batch.
+    string path;
+    long long input_bytes = -1;
+    long long graph_bytes = -1;
+    string settings;
+
+    // Size of the named file in bytes, -1 if it cannot be read.
+    static long long FileBytes(const string& name) {
+        error_code ec;
+        uintmax_t size = filesystem::file_size(name, ec);
+        return ec ? -1 : (long long)size;
+    }
+
+public:
+    // Number of inputs done and output length in bytes when last recorded.
+    size_t done = 0;
+    long long offset = 0;
+
+    // Whether the last load found a checkpoint of a different batch.
+    bool mismatch = false;
+
+    /*
+     * Checkpoint of the batch reading the named input and graph files and
+     * writing the named output file.
+     *
+     * Parameters:
+     *  output -
+     *      Name of the output file.
+     *  input -
+     *      Name of the input file.
+     *  graph -
+     *      Name of the graph file.
+     *  batch_settings -
+     *      Settings the results depend on, on one line.
+     */
+    Checkpoint(const string& output, const string& input,
+               const string& graph, const string& batch_settings)
+        : path(output + ".ckpt"), input_bytes(FileBytes(input)),
+          graph_bytes(FileBytes(graph)), settings(batch_settings) {}
+
+    /*
+     * Reads the checkpoint, if any, into done and offset. Sets mismatch if
+     * one was found but records other files or settings.
+     *
+     * Returns:
+     *  bool -
+     *      True if a checkpoint of the same batch was read.
+     */
+    bool load() {
+        ifstream in(path);
+        string name, recorded;
+        long long input = -1, graph = -1;
+        mismatch = false;
+        if (!(in >> name >> input) || name != "input" ||
+            input != input_bytes ||
+            !(in >> name >> graph) || name != "graph" ||
+            graph != graph_bytes ||
+            !(in >> name) || name != "settings" || in.get() != '\t' ||
+            !getline(in, recorded) || recorded != settings ||
+            !(in >> name >> done) || name != "done" ||
+            !(in >> name >> offset) || name != "offset") {
+            mismatch = (bool)ifstream(path);
+            done = 0;
+            offset = 0;
+            return false;
+        }
+        return true;
+    }
+
+    /*
+     * Opens the output of the batch, continuing from the loaded checkpoint.
+     * The output is cut back to the checkpoint's length, or created empty if
+     * no checkpoint was loaded.
+     *
+     * Parameters:
+     *  out -
+     *      Stream to open, positioned at the end of the kept output.
+     *  output -
+     *      Name of the output file.
+     *
+     * Returns:
+     *  bool -
+     *      True if the output was opened. False if it is shorter than the
+     *      checkpoint records, and so not the output checkpointed.
+     */
+    bool open(ofstream& out, const string& output) {
+        if (done == 0 && offset == 0) {
+            out.open(output);
+            return (bool)out;
+        }
+        error_code ec;
+        if ((long long)filesystem::file_size(output, ec) < offset || ec)
+            return false;
+        filesystem::resize_file(output, offset, ec);
+        if (ec)
+            return false;
+        out.open(output, ios::in | ios::out);
+        out.seekp(offset);
+        return (bool)out;
+    }
+
+    /*
+     * Flushes out and records that the first inputs_done inputs are done.
+     *
+     * Parameters:
+     *  out -
+     *      Output of the batch, holding the results of the done inputs.
+     *  inputs_done -
+     *      Number of inputs whose results are in out.
+     */
+    void save(ofstream& out, size_t inputs_done) {
+        TRACE_SCOPE("checkpoint");
+        out.flush();
+        done = inputs_done;
+        offset = (long long)out.tellp();
+        string temp = path + ".tmp";
+        {
+            ofstream ckpt(temp);
+            ckpt << "input\t" << input_bytes << "\ngraph\t" << graph_bytes
+                 << "\nsettings\t" << settings << "\ndone\t" << done
+                 << "\noffset\t" << offset << "\n";
+        }
+        rename(temp.c_str(), path.c_str());
+    }
+
+    // Deletes the checkpoint once the batch has finished.
+    void remove() { std::remove(path.c_str()); }
+};
+
+#endif  // CHECKPOINT_HPP
@@ -0,0 +1,141 @@
+/*
+ * This file implements DistanceSketch, an oracle estimating the hops between
+ * actors from seed set sketches. See distancesketch.hpp.
+ */
+
+#include <algorithm>
+#include <climits>
+#include <random>
+#include <vector>
+#include "actorgraph.hpp"
+#include "distancesketch.hpp"
+#include "parallel.hpp"
+#include "trace.hpp"
+#include "traversal.hpp"
+
+using namespace std;
+
+// Visitor passing the nearest seed of an actor on to the actors it reaches.
+struct SeedVisitor : TraversalVisitor {
+    vector<int>& nearest;
+    explicit SeedVisitor(vector<int>& n) : nearest(n) {}
+    void on_relax(int v, int, int from, int) { nearest[v] = nearest[from]; }
+};
+
+
+/*
+ * Builds the sketches of graph with numThreads() threads. See
+ * distancesketch.hpp.
+ *
+ * Parameters:
+ *  graph -
+ *      Loaded graph to sketch.
+ *  repetitions -
+ *      Number of seed sets drawn of each size.
+ *  seed -
+ *      Seed of the random draws.
+ */
+void DistanceSketch::build(const ActorGraph& graph, int repetitions,
+                           unsigned seed) {
+    TRACE_SCOPE("sketch");
+    num_actors = graph.numActors();
+    int levels = 0;
+    while (num_actors > 0 && (1LL << levels) <= num_actors)
+        levels++;
+    width = max(1, repetitions) * levels;
+    entries.assign((size_t)num_actors * width, Entry{INT_MAX, 0});
+    if (num_actors == 0)
+        return;
+
+    // Draw the seed sets up front, so they do not depend on the threads
+    mt19937 random(seed);
+    vector<vector<int>> seeds(width);
+    vector<int> ids(num_actors);
+    for (int s = 0; s < width; s++) {
+        for (int i = 0; i < num_actors; i++)
+            ids[i] = i;
+        int size = 1 << (s % levels);
+        for (int i = 0; i < size; i++) {
+            int j = i + (int)(random() % (unsigned)(num_actors - i));
+            swap(ids[i], ids[j]);
+        }
+        seeds[s].assign(ids.begin(), ids.begin() + size);
+    }
+
+    // Search from every seed of a set at once, recording each actor's nearest
+    // seed into the entry of the set
+    vector<SearchState> states(numThreads());
+    vector<vector<int>> nearest(numThreads());
+    parallelFor(0, width, 1, [&](int lo, int hi, int t) {
+        SearchState& state = states[t];
+        if (nearest[t].empty()) {
+            state.resize(graph);
+            nearest[t].assign(num_actors, -1);
+        }
+        for (int s = lo; s < hi; s++) {
+            state.reset();
+            FifoFrontier frontier(state);
+            for (int v : seeds[s]) {
+                addSource(state, frontier, v);
+                nearest[t][v] = v;
+            }
+            SeedVisitor visitor(nearest[t]);
+            traverse(graph, state, frontier, UnitWeight(), visitor);
+            for (int v : state.touched)
+                entries[(size_t)v * width + s] =
+                    Entry{nearest[t][v], state.dist[v]};
+        }
+    });
+
+    // Sort each sketch by seed, keeping the fewest hops to a repeated seed
+    parallelFor(0, num_actors, 1024, [&](int lo, int hi, int) {
+        for (int v = lo; v < hi; v++) {
+            Entry* first = &entries[(size_t)v * width];
+            Entry* last = first + width;
+            sort(first, last, [](const Entry& x, const Entry& y) {
+                return x.seed != y.seed ? x.seed < y.seed : x.hops < y.hops;
+            });
+            Entry* end = unique(first, last, [](const Entry& x,
+                                                const Entry& y) {
+                return x.seed == y.seed;
+            });
+            fill(end, last, Entry{INT_MAX, 0});
+        }
+    });
+}
+
+
+/*
+ * Estimates the hops between two actors by merging their sketches. See
+ * distancesketch.hpp.
+ *
+ * Parameters:
+ *  u, v -
+ *      Actor ids.
+ *
+ * Returns:
+ *  int -
+ *      Estimated hops, or -1 if the sketches share no seed.
+ */
+int DistanceSketch::estimate(int u, int v) const {
+    if (u == v)
+        return 0;
+    const Entry* a = &entries[(size_t)u * width];
+    const Entry* b = &entries[(size_t)v * width];
+    const Entry* a_end = a + width;
+    const Entry* b_end = b + width;
+    int best = INT_MAX;
+    while (a < a_end && b < b_end && a->seed != INT_MAX &&
+           b->seed != INT_MAX) {
+        if (a->seed < b->seed) {
+            a++;
+        } else if (b->seed < a->seed) {
+            b++;
+        } else {
+            best = min(best, a->hops + b->hops);
+            a++;
+            b++;
+        }
+    }
+    return best == INT_MAX ? -1 : best;
+}
@@ -0,0 +1,87 @@
+/*
+ * This file declares DistanceSketch, an oracle estimating the hops between
+ * any two actors from small per actor sketches (Das Sarma et al., "A Sketch
+ * Based Distance Oracle for Web-Scale Graphs", WSDM 2010).
+ *
+ * Seed sets of 1, 2, 4, ... actors up to the number of actors are drawn at
+ * random, several times over. One breadth first search from all seeds of a
+ * set finds, for every actor, its nearest seed and the hops to it. The
+ * sketch of an actor is these (seed, hops) entries over every set, sorted
+ * by seed. Two actors sharing a seed w are joined by a walk through w, so
+ *
+ *  estimate(u, v) = min over common seeds w of hops(u, w) + hops(w, v)
+ *
+ * which never undercounts the true hops d(u, v). With a number of
+ * repetitions logarithmic in the number of actors n the estimate is at most
+ * (2 log2(n) - 1) d(u, v) with high probability; fewer repetitions keep the
+ * bound in expectation only. Connected actors may still share no seed: a
+ * set's seeds reach only their own components, and an actor that is a seed
+ * is its own nearest one. Such pairs estimate -1, as unconnected ones do.
+ *
+ * The sketches take repetitions * (log2(n) + 1) entries per actor, against
+ * n per actor for exact labels, and a query is one merge of two short
+ * sorted arrays.
+ */
+
+#ifndef DISTANCESKETCH_HPP
+#define DISTANCESKETCH_HPP
+
+#include <cstddef>
+#include <vector>
+#include "actorgraph.hpp"
+
+using namespace std;
+
+class DistanceSketch {
+private:
+    // Nearest seed of a set and the hops to it. Unused entries of a sketch
+    // follow the used ones with seed INT_MAX.
+    struct Entry {
+        int seed;
+        int hops;
+    };
+
+    // Entries per actor, one per seed set, and number of actors
+    int width = 0;
+    int num_actors = 0;
+
+    // Sketch of actor v at entries[v * width, (v + 1) * width)
+    vector<Entry> entries;
+
+public:
+    /*
+     * Builds the sketches of graph with numThreads() threads, one seed set
+     * search per thread at a time.
+     *
+     * Parameters:
+     *  graph -
+     *      Loaded graph to sketch.
+     *  repetitions -
+     *      Number of seed sets drawn of each size.
+     *  seed -
+     *      Seed of the random draws, so builds can be repeated.
+     */
+    void build(const ActorGraph& graph, int repetitions, unsigned seed = 1);
+
+    /*
+     * Estimates the hops between two actors.
+     *
+     * Parameters:
+     *  u, v -
+     *      Actor ids.
+     *
+     * Returns:
+     *  int -
+     *      Hops of a walk between u and v no shorter than the shortest, or -1
+     *      if their sketches share no seed, as for unconnected actors.
+     */
+    int estimate(int u, int v) const;
+
+    // Number of seed sets, the most entries in any sketch.
+    int numSets() const { return width; }
+
+    // Bytes held by the sketches.
+    size_t bytes() const { return entries.capacity() * sizeof(Entry); }
+};
+
+#endif  // DISTANCESKETCH_HPP
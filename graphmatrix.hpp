@@ -0,0 +1,43 @@
+/*
+ * This file builds the sparse matrices of sparsematrix.hpp from an
+ * ActorGraph, so kernels over the actor network can be written as semiring
+ * products.
+ *
+ *  incidenceMatrix  - actors by movies, 1 where the actor is in the movie.
+ *  coStarMatrix     - actors by actors, 1 where two distinct actors share at
+ *                     least one movie. This is the incidence matrix times
+ *                     its transpose over OrAnd, with the diagonal masked off.
+ */
+
+#ifndef GRAPHMATRIX_HPP
+#define GRAPHMATRIX_HPP
+
+#include <algorithm>
+#include "actorgraph.hpp"
+#include "sparsematrix.hpp"
+
+using namespace std;
+
+// Actors by movies incidence pattern of graph.
+inline CsrMatrix<char> incidenceMatrix(const ActorGraph& graph) {
+    CsrMatrix<char> b;
+    b.rows = graph.numActors();
+    b.cols = graph.numMovies();
+    b.offsets.resize(b.rows + 1);
+    for (int a = 0; a < b.rows; a++) {
+        IdRange movies = graph.moviesOf(a);
+        b.indices.insert(b.indices.end(), movies.begin(), movies.end());
+        sort(b.indices.end() - movies.size(), b.indices.end());
+        b.offsets[a + 1] = (int)b.indices.size();
+    }
+    b.values.assign(b.indices.size(), 1);
+    return b;
+}
+
+// Actors by actors pattern of shared movies, without self loops.
+inline CsrMatrix<char> coStarMatrix(const ActorGraph& graph) {
+    CsrMatrix<char> b = incidenceMatrix(graph);
+    return maskedSpgemm<OrAnd>(b, transpose(b), identityMatrix(b.rows), true);
+}
+
+#endif  // GRAPHMATRIX_HPP
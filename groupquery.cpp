@@ -0,0 +1,319 @@
+/*
+ * This file implements the group queries declared in groupquery.hpp.
+ */
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <numeric>
+#include <ostream>
+#include <tuple>
+#include <vector>
+#include "actorgraph.hpp"
+#include "groupquery.hpp"
+#include "traversal.hpp"
+
+using namespace std;
+
+// Visitor passing the region of an actor on to the actors it relaxes.
+struct RegionVisitor : TraversalVisitor {
+    vector<int>& region;
+    explicit RegionVisitor(vector<int>& r) : region(r) {}
+    void on_relax(int v, int, int from, int) { region[v] = region[from]; }
+};
+
+// Cheapest known connection between two regions through a movie.
+struct Bridge {
+    long long weight;
+    int first;      // regions joined, first < second
+    int second;
+    int from;       // actors of each region sharing the movie
+    int to;
+    int movie;
+};
+
+
+// Root of x in a union-find forest, halving paths as it goes.
+static int FindRoot(vector<int>& parent, int x) {
+    while (parent[x] != x)
+        x = parent[x] = parent[parent[x]];
+    return x;
+}
+
+
+GroupSearcher::GroupSearcher(const ActorGraph& g, const Exclusions* a)
+    : graph(g), avoid(a), state(g), region(g.numActors(), -1),
+      in_tree(g.numActors(), 0) {}
+
+
+/*
+ * Writes a tree of movies connecting every actor of a group, of weight at
+ * most twice the minimum. See groupquery.hpp.
+ *
+ * Parameters:
+ *  out -
+ *      Stream receiving the tree as tab separated edges.
+ *  members -
+ *      Actor ids of the group. Nothing is written if any is -1 or excluded.
+ */
+void GroupSearcher::steinerTree(ostream& out, const vector<int>& members) {
+    vector<int> group(members);
+    sort(group.begin(), group.end());
+    group.erase(unique(group.begin(), group.end()), group.end());
+    if (group.empty() || group.front() < 0)
+        return;
+    for (int v : group) {
+        if (avoid && avoid->hasActor(v))
+            return;
+    }
+    if (group.size() == 1) {
+        out << "(" << graph.actorName(group[0]) << ")";
+        return;
+    }
+
+    // Split the actors into regions by nearest member, in one search
+    state.reset();
+    HeapFrontier<> frontier(state);
+    for (int r = 0; r < (int)group.size(); r++) {
+        addSource(state, frontier, group[r]);
+        region[group[r]] = r;
+    }
+    if (avoid) {
+        AvoidingVisitor<RegionVisitor> visitor(avoid, RegionVisitor(region));
+        traverse(graph, state, frontier, MovieWeight(), visitor);
+    } else {
+        RegionVisitor visitor(region);
+        traverse(graph, state, frontier, MovieWeight(), visitor);
+    }
+
+    // Find the cheapest bridge between each two regions. Within a movie only
+    // the closest cast member of each region can be part of one.
+    int k = (int)group.size();
+    vector<Bridge> best(k * k, Bridge{-1, 0, 0, -1, -1, -1});
+    vector<int> closest(k, -1);
+    vector<int> present;
+    for (int m : state.touched_movies) {
+        present.clear();
+        for (int c : graph.castOf(m)) {
+            if (state.dist[c] == UNREACHED)
+                continue;
+            int& r = closest[region[c]];
+            if (r < 0)
+                present.push_back(region[c]);
+            if (r < 0 || state.dist[c] < state.dist[r])
+                r = c;
+        }
+        sort(present.begin(), present.end());
+        for (size_t i = 0; i < present.size(); i++) {
+            for (size_t j = i + 1; j < present.size(); j++) {
+                int u = closest[present[i]];
+                int v = closest[present[j]];
+                long long weight = (long long)state.dist[u] +
+                                   graph.movieWeight(m) + state.dist[v];
+                Bridge& b = best[present[i] * k + present[j]];
+                if (b.weight < 0 || weight < b.weight)
+                    b = Bridge{weight, present[i], present[j], u, v, m};
+            }
+        }
+        for (int r : present)
+            closest[r] = -1;
+    }
+
+    // Join the regions along a minimum spanning tree of the bridges
+    vector<Bridge> bridges;
+    for (const Bridge& b : best) {
+        if (b.weight >= 0)
+            bridges.push_back(b);
+    }
+    sort(bridges.begin(), bridges.end(), [](const Bridge& x, const Bridge& y) {
+        return tie(x.weight, x.first, x.second) <
+               tie(y.weight, y.first, y.second);
+    });
+    vector<int> parent(k);
+    iota(parent.begin(), parent.end(), 0);
+
+    // Writes an edge, and the path from actor v back to its member up to
+    // where it meets the tree
+    bool first_edge = true;
+    vector<int> marked;
+    auto edge = [&](int from, int movie, int to) {
+        out << (first_edge ? "" : "\t") << "(" << graph.actorName(from)
+            << ")--[" << graph.movieTitle(movie) << "]-->("
+            << graph.actorName(to) << ")";
+        first_edge = false;
+    };
+    auto writeBranch = [&](int v) {
+        while (state.prev_actor[v] != -1 && !in_tree[v]) {
+            in_tree[v] = 1;
+            marked.push_back(v);
+            edge(state.prev_actor[v], state.prev_movie[v], v);
+            v = state.prev_actor[v];
+        }
+    };
+    for (const Bridge& b : bridges) {
+        int x = FindRoot(parent, b.first);
+        int y = FindRoot(parent, b.second);
+        if (x == y)
+            continue;
+        parent[max(x, y)] = min(x, y);
+        writeBranch(b.from);
+        edge(b.from, b.movie, b.to);
+        writeBranch(b.to);
+    }
+    for (int v : marked)
+        in_tree[v] = 0;
+}
+
+
+/*
+ * Writes the actor minimizing the sum, or the largest, of its hops to the
+ * members of a group. See groupquery.hpp.
+ *
+ * Parameters:
+ *  out -
+ *      Stream receiving the actor, its sum and largest hops, and its hops to
+ *      each member.
+ *  members -
+ *      Actor ids of the group, at most 64.
+ *  minimize_max -
+ *      Whether to minimize the largest hops rather than the sum.
+ */
+void GroupSearcher::meetingPoint(ostream& out, const vector<int>& members,
+                                 bool minimize_max) {
+    int k = (int)members.size();
+    if (k == 0 || k > 64 ||
+        *min_element(members.begin(), members.end()) < 0)
+        return;
+    for (int v : members) {
+        if (avoid && avoid->hasActor(v))
+            return;
+    }
+    if (reached.empty()) {
+        reached.assign(graph.numActors(), 0);
+        fresh.assign(graph.numActors(), 0);
+        next_fresh.assign(graph.numActors(), 0);
+        hop_sum.assign(graph.numActors(), 0);
+        movie_passed.assign(graph.numMovies(), 0);
+        movie_fresh.assign(graph.numMovies(), 0);
+    }
+    uint64_t all = k == 64 ? ~0ULL : (1ULL << k) - 1;
+
+    // Actors and movies labelled, to clear afterwards, and the actors
+    // reached in the current hop with the members reaching them
+    vector<int> touched;
+    vector<int> touched_movies;
+    vector<int> current;
+    vector<int> next;
+    vector<int> passing;
+    vector<pair<int, uint64_t>> arrivals;
+    vector<int> arrival_hops;
+    for (int i = 0; i < k; i++) {
+        int v = members[i];
+        if (!reached[v])
+            touched.push_back(v);
+        if (!fresh[v])
+            current.push_back(v);
+        reached[v] |= 1ULL << i;
+        fresh[v] |= 1ULL << i;
+    }
+
+    int best = -1;
+    int best_cost = 0;
+    for (int hops = 0; !current.empty(); hops++) {
+        // Score the actors reached in this hop, keeping the best complete one
+        for (int v : current) {
+            hop_sum[v] += hops * __builtin_popcountll(fresh[v]);
+            arrivals.push_back(pair<int, uint64_t>(v, fresh[v]));
+            arrival_hops.push_back(hops);
+            if (reached[v] != all)
+                continue;
+            int cost = minimize_max ? hops : hop_sum[v];
+            if (best < 0 || cost < best_cost ||
+                (cost == best_cost && v < best)) {
+                best = v;
+                best_cost = cost;
+            }
+        }
+
+        // Stop once no actor still missing members can do better: each
+        // missing member is at least one more hop away
+        if (best >= 0) {
+            if (minimize_max)
+                break;
+            long long bound = (long long)k * (hops + 1);
+            if ((int)touched.size() == graph.numActors())
+                bound = LLONG_MAX;
+            for (int v : touched) {
+                if (reached[v] == all)
+                    continue;
+                int missing = k - __builtin_popcountll(reached[v]);
+                bound = min(bound, (long long)hop_sum[v] +
+                                   (long long)missing * (hops + 1));
+            }
+            if (best_cost < bound)
+                break;
+        }
+
+        // Pass the members reaching each actor on through its movies
+        for (int v : current) {
+            for (int m : graph.moviesOf(v)) {
+                uint64_t add = fresh[v] & ~movie_passed[m];
+                if (!add || (avoid && avoid->hasMovie(m)))
+                    continue;
+                if (!movie_passed[m])
+                    touched_movies.push_back(m);
+                if (!movie_fresh[m])
+                    passing.push_back(m);
+                movie_fresh[m] |= add;
+                movie_passed[m] |= add;
+            }
+        }
+        for (int m : passing) {
+            for (int c : graph.castOf(m)) {
+                uint64_t add = movie_fresh[m] & ~reached[c];
+                if (!add || (avoid && avoid->hasActor(c)))
+                    continue;
+                if (!reached[c])
+                    touched.push_back(c);
+                if (!next_fresh[c])
+                    next.push_back(c);
+                reached[c] |= add;
+                next_fresh[c] |= add;
+            }
+            movie_fresh[m] = 0;
+        }
+        passing.clear();
+        for (int v : current)
+            fresh[v] = 0;
+        fresh.swap(next_fresh);
+        current.swap(next);
+        next.clear();
+    }
+
+    // Write the best actor with its hops to each member
+    if (best >= 0) {
+        vector<int> member_hops(k, 0);
+        for (size_t a = 0; a < arrivals.size(); a++) {
+            if (arrivals[a].first != best)
+                continue;
+            for (int i = 0; i < k; i++) {
+                if (arrivals[a].second >> i & 1)
+                    member_hops[i] = arrival_hops[a];
+            }
+        }
+        out << "(" << graph.actorName(best) << ")\t" << hop_sum[best] << '\t'
+            << *max_element(member_hops.begin(), member_hops.end()) << '\t';
+        for (int i = 0; i < k; i++)
+            out << (i ? "," : "") << member_hops[i];
+    }
+
+    // Clear the labels for the next query
+    for (int v : touched) {
+        reached[v] = 0;
+        hop_sum[v] = 0;
+    }
+    for (int v : current)
+        fresh[v] = 0;
+    for (int m : touched_movies)
+        movie_passed[m] = 0;
+}
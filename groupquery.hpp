@@ -0,0 +1,101 @@
+/*
+ * This file declares GroupSearcher, which answers queries about a group of
+ * actors at once rather than a pair:
+ *
+ *  steinerTree  - the movies and actors connecting the whole group, by
+ *                 Mehlhorn's approximation of the minimum Steiner tree.
+ *  meetingPoint - the actor closest to the whole group, by the sum or the
+ *                 largest of its hops to the members.
+ *
+ * Each query costs about one traversal of the graph, however large the
+ * group.
+ */
+
+#ifndef GROUPQUERY_HPP
+#define GROUPQUERY_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#include "actorgraph.hpp"
+#include "traversal.hpp"
+
+using namespace std;
+
+/*
+ * Labels and scratch space of group queries on one thread, kept between
+ * queries. Not safe to share between threads.
+ */
+class GroupSearcher {
+private:
+    const ActorGraph& graph;
+    // Actors and movies no query may pass through, or null
+    const Exclusions* avoid;
+    SearchState state;
+    // Group member whose region each reached actor lies in
+    vector<int> region;
+    // Flags actors whose path to their member is already in the tree
+    vector<char> in_tree;
+
+    // Meeting point labels, one bit per member: members known to reach each
+    // actor, and those reaching it in the current and next hop. Movies hold
+    // the members which have passed through them, and those passing through
+    // in the current hop. Sized on first use.
+    vector<uint64_t> reached;
+    vector<uint64_t> fresh;
+    vector<uint64_t> next_fresh;
+    vector<uint64_t> movie_passed;
+    vector<uint64_t> movie_fresh;
+    // Sum of hops from the members reaching each actor
+    vector<int> hop_sum;
+
+public:
+    // Searcher over graph avoiding the exclusions, if any, both of which
+    // must outlive it.
+    explicit GroupSearcher(const ActorGraph& graph,
+                           const Exclusions* avoid = nullptr);
+
+    /*
+     * Writes a tree of movies connecting every actor of a group, of weight
+     * at most twice the minimum (Mehlhorn, 1988). One Dijkstra search from
+     * all members at once splits the actors into regions by their nearest
+     * member. Each movie shared across two regions gives a candidate
+     * connection between their members, of weight the distance of each end
+     * to its member plus the movie's. A minimum spanning tree over the
+     * members' best connections is expanded into the paths forming it.
+     *
+     * Parameters:
+     *  out -
+     *      Stream receiving the tree as tab separated edges, each formatted
+     *      (actor)--[movie#@year]-->(actor). A lone actor is written alone.
+     *  members -
+     *      Actor ids of the group. Nothing is written if any is -1 or
+     *      excluded.
+     */
+    void steinerTree(ostream& out, const vector<int>& members);
+
+    /*
+     * Writes the actor minimizing the sum, or the largest, of its hops to
+     * the members of a group. Breadth first searches from every member run
+     * at once over the graph, one bit of a word per member, so each hop
+     * costs one pass over the actors and movies reached whatever the size
+     * of the group. The search stops as soon as the best actor is certain:
+     * for the largest hops at the first hop some actor is reached by every
+     * member, for the sum once no actor still missing members can beat the
+     * best complete one. Ties go to the actor first by name.
+     *
+     * Parameters:
+     *  out -
+     *      Stream receiving the actor, its sum and largest hops, and its
+     *      hops to each member in order, comma separated, all tab separated.
+     *  members -
+     *      Actor ids of the group, at most 64. Nothing is written if any is
+     *      -1 or excluded, or no actor is reached by every member.
+     *  minimize_max -
+     *      Whether to minimize the largest hops rather than the sum.
+     */
+    void meetingPoint(ostream& out, const vector<int>& members,
+                      bool minimize_max);
+};
+
+#endif  // GROUPQUERY_HPP
@@ -0,0 +1,225 @@
+/*
+ * This file implements the HyperANF estimate of the neighbourhood function
+ * of the co-star graph. See hyperanf.hpp.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "actorgraph.hpp"
+#include "hyperanf.hpp"
+#include "parallel.hpp"
+#include "trace.hpp"
+
+using namespace std;
+
+// High bit of every byte of a word
+const static uint64_t HIGH_BITS = 0x8080808080808080ULL;
+
+
+// Mixes x into a 64 bit hash (splitmix64 finalizer).
+static uint64_t Mix(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+
+/*
+ * Takes the byte wise maximum of counter src into counter dst, eight
+ * registers a word. Registers stay under 128, so subtracting a byte of src
+ * from the byte of dst with its high bit set never borrows from the next
+ * byte, and leaves the high bit set exactly where dst is at least src.
+ *
+ * Parameters:
+ *  dst, src -
+ *      Counters of the given words.
+ *  words -
+ *      Words per counter.
+ *
+ * Returns:
+ *  bool -
+ *      True if any register of dst grew.
+ */
+static bool MaxInto(uint64_t* dst, const uint64_t* src, int words) {
+    uint64_t grew = 0;
+    for (int i = 0; i < words; i++) {
+        uint64_t a = dst[i], b = src[i];
+        uint64_t keep = ((((a | HIGH_BITS) - b) & HIGH_BITS) >> 7) * 0xff;
+        uint64_t larger = (a & keep) | (b & ~keep);
+        grew |= larger ^ a;
+        dst[i] = larger;
+    }
+    return grew != 0;
+}
+
+
+/*
+ * Estimates the distinct actors added to a counter: the harmonic mean of
+ * 2^register, corrected by linear counting of the empty registers while
+ * the estimate is small.
+ *
+ * Parameters:
+ *  counter -
+ *      Counter of the given registers.
+ *  registers -
+ *      Registers of the counter, 2^b.
+ *
+ * Returns:
+ *  double -
+ *      Estimated actors added.
+ */
+static double Estimate(const uint64_t* counter, int registers) {
+    const uint8_t* r = (const uint8_t*)counter;
+    double sum = 0;
+    int zeros = 0;
+    for (int j = 0; j < registers; j++) {
+        sum += ldexp(1.0, -r[j]);
+        zeros += r[j] == 0;
+    }
+    double m = registers;
+    double alpha = registers == 16 ? 0.673 : registers == 32 ? 0.697
+                 : registers == 64 ? 0.709 : 0.7213 / (1 + 1.079 / m);
+    double estimate = alpha * m * m / sum;
+    if (estimate <= 2.5 * m && zeros > 0)
+        estimate = m * log(m / zeros);
+    return estimate;
+}
+
+
+/*
+ * Estimates the neighbourhood function of the co-star graph of graph with
+ * numThreads() threads, stepping counters one hop further until none
+ * changes.
+ *
+ * Parameters:
+ *  graph -
+ *      Loaded graph.
+ *  log2_registers -
+ *      Base two logarithm b of the registers per counter, from 4 to 16.
+ *  seed -
+ *      Seed of the hash of the actors.
+ *
+ * Returns:
+ *  NeighborhoodFunction -
+ *      Estimated pairs within each hops, reach and harmonic centrality.
+ */
+NeighborhoodFunction hyperAnf(const ActorGraph& graph, int log2_registers,
+                              unsigned long long seed) {
+    TRACE_SCOPE("hyperanf");
+    int b = min(max(log2_registers, 4), 16);
+    int registers = 1 << b;
+    int words = registers / 8;
+    int num_actors = graph.numActors();
+    int num_movies = graph.numMovies();
+
+    // Counter of each actor and movie at [id * words, (id + 1) * words)
+    vector<uint64_t> actor_counters((size_t)num_actors * words, 0);
+    vector<uint64_t> movie_counters((size_t)num_movies * words, 0);
+    vector<char> actor_changed(num_actors, 1);
+    vector<char> movie_changed(num_movies, 0);
+
+    // Each actor adds itself to its counter
+    NeighborhoodFunction result;
+    result.reachable.assign(num_actors, 0);
+    result.harmonic.assign(num_actors, 0);
+    double pairs = 0;
+    for (int a = 0; a < num_actors; a++) {
+        uint64_t hash = Mix(seed * 0x100000001b3ULL + a);
+        int index = (int)(hash & (registers - 1));
+        uint64_t rest = hash >> b;
+        int value = rest ? __builtin_ctzll(rest) + 1 : 64 - b + 1;
+        uint8_t* r = (uint8_t*)&actor_counters[(size_t)a * words];
+        r[index] = (uint8_t)value;
+        result.reachable[a] = Estimate(&actor_counters[(size_t)a * words],
+                                       registers);
+        pairs += result.reachable[a];
+    }
+    result.pairs.push_back(pairs);
+
+    vector<double> gained(numThreads());
+    vector<char> changed(numThreads());
+    for (int t = 1; ; t++) {
+        TRACE_SCOPE("hyperanf step");
+        // Movies take in the cast members that changed last step
+        parallelFor(0, num_movies, 256, [&](int lo, int hi, int) {
+            for (int m = lo; m < hi; m++) {
+                bool grew = false;
+                uint64_t* counter = &movie_counters[(size_t)m * words];
+                for (int a : graph.castOf(m)) {
+                    if (actor_changed[a]) {
+                        grew |= MaxInto(counter,
+                                        &actor_counters[(size_t)a * words],
+                                        words);
+                    }
+                }
+                movie_changed[m] = grew;
+            }
+        });
+
+        // Actors take in their movies that changed, estimating anew
+        fill(gained.begin(), gained.end(), 0);
+        fill(changed.begin(), changed.end(), 0);
+        parallelFor(0, num_actors, 64, [&](int lo, int hi, int thread) {
+            for (int a = lo; a < hi; a++) {
+                bool grew = false;
+                uint64_t* counter = &actor_counters[(size_t)a * words];
+                for (int m : graph.moviesOf(a)) {
+                    if (movie_changed[m]) {
+                        grew |= MaxInto(counter,
+                                        &movie_counters[(size_t)m * words],
+                                        words);
+                    }
+                }
+                actor_changed[a] = grew;
+                if (!grew)
+                    continue;
+                double reach = Estimate(counter, registers);
+                double gain = reach - result.reachable[a];
+                result.harmonic[a] += gain / t;
+                result.reachable[a] = reach;
+                gained[thread] += gain;
+                changed[thread] = 1;
+            }
+        });
+
+        if (find(changed.begin(), changed.end(), 1) == changed.end())
+            break;
+        for (double gain : gained)
+            pairs += gain;
+        result.pairs.push_back(pairs);
+    }
+    return result;
+}
+
+
+/*
+ * Finds the hops within which a share of the pairs of distinct connected
+ * actors lie, interpolated linearly between whole hops.
+ *
+ * Parameters:
+ *  pairs -
+ *      Pairs within each hops, as in NeighborhoodFunction.
+ *  share -
+ *      Share of the pairs, 0.9 for the effective diameter.
+ *
+ * Returns:
+ *  double -
+ *      Hops holding the share of the pairs, 0 if there are none.
+ */
+double effectiveDiameter(const vector<double>& pairs, double share) {
+    if (pairs.size() < 2)
+        return 0;
+    double target = share * (pairs.back() - pairs[0]);
+    for (size_t t = 1; t < pairs.size(); t++) {
+        double within = pairs[t] - pairs[0];
+        if (within >= target) {
+            double before = pairs[t - 1] - pairs[0];
+            double step = within - before;
+            return t - 1 + (step > 0 ? (target - before) / step : 1);
+        }
+    }
+    return pairs.size() - 1;
+}
@@ -0,0 +1,80 @@
+/*
+ * This file declares the neighbourhood function of the co-star graph,
+ * estimated by HyperANF (Boldi et al., "HyperANF: Approximating the
+ * Neighbourhood Function of Very Large Graphs on a Budget", WWW 2011): for
+ * every t, the pairs of actors within t hops of each other, and from it the
+ * distribution of hops, the effective diameter and the harmonic centrality
+ * of every actor, without a search from every actor.
+ *
+ * Every actor holds a HyperLogLog counter (Flajolet et al., 2007) of the
+ * actors within t hops of it, starting with itself. A counter is 2^b one
+ * byte registers; an actor is hashed to a register and a value, the position
+ * of the lowest set bit of the rest of its hash, and a register keeps the
+ * largest value it sees. Counters are unions of sets, so the counter of an
+ * actor within t + 1 hops is the register wise maximum of the counters of
+ * its co-stars within t hops. A step is two passes over the roles, each in
+ * parallel: movies take the maximum over their cast, then actors over their
+ * movies, so casts are never expanded into co-star pairs. Only movies with a
+ * cast member that changed, and actors with such a movie, are visited. The
+ * maximum is taken eight registers at a time in 64 bit words. Steps stop
+ * once no counter changes, after as many steps as the largest hops.
+ *
+ * A counter estimates its size with a relative standard error of about
+ * 1.04 / sqrt(2^b), and takes 2^b bytes per actor and movie.
+ */
+
+#ifndef HYPERANF_HPP
+#define HYPERANF_HPP
+
+#include <vector>
+#include "actorgraph.hpp"
+
+using namespace std;
+
+// Estimated neighbourhood function of a graph.
+struct NeighborhoodFunction {
+    // Ordered pairs of actors within t hops, an actor with itself
+    // included, at [t]
+    vector<double> pairs;
+    // Actors within reach of each actor, itself included, by id
+    vector<double> reachable;
+    // Sum over the actors reachable from each actor of one over the hops
+    vector<double> harmonic;
+};
+
+/*
+ * Estimates the neighbourhood function of the co-star graph of graph with
+ * numThreads() threads.
+ *
+ * Parameters:
+ *  graph -
+ *      Loaded graph.
+ *  log2_registers -
+ *      Base two logarithm b of the registers per counter, from 4 to 16.
+ *  seed -
+ *      Seed of the hash of the actors.
+ *
+ * Returns:
+ *  NeighborhoodFunction -
+ *      Estimated pairs within each hops, reach and harmonic centrality.
+ */
+NeighborhoodFunction hyperAnf(const ActorGraph& graph, int log2_registers,
+                              unsigned long long seed = 1);
+
+/*
+ * Finds the hops within which a share of the pairs of distinct connected
+ * actors lie, interpolated linearly between whole hops.
+ *
+ * Parameters:
+ *  pairs -
+ *      Pairs within each hops, as in NeighborhoodFunction.
+ *  share -
+ *      Share of the pairs, 0.9 for the effective diameter.
+ *
+ * Returns:
+ *  double -
+ *      Hops holding the share of the pairs, 0 if there are none.
+ */
+double effectiveDiameter(const vector<double>& pairs, double share = 0.9);
+
+#endif  // HYPERANF_HPP
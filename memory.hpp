@@ -0,0 +1,115 @@
+/*
+ * This file contains the memory accounting of the programs. Each graph,
+ * index and cache structure adds the bytes it holds to a MemoryReport, which
+ * lists them with their share of the total beside the resident set size of
+ * the process, so memory optimizations can be measured structure by
+ * structure.
+ *
+ * Bytes are counted by capacity, not size: a vector holds capacity elements,
+ * a string its characters once too long to be stored inline, and a hash map
+ * its bucket array and a node per entry (the layout of libstdc++: a next
+ * pointer, the entry and its cached hash). Allocator overhead per block is
+ * not counted, so the total is a lower bound of what the structures hold.
+ */
+
+#ifndef MEMORY_HPP
+#define MEMORY_HPP
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Heap bytes of a string, 0 while it is stored inline.
+inline size_t memoryBytes(const string& s) {
+    const char* data = s.data();
+    const char* self = (const char*)&s;
+    bool inline_storage = data >= self && data < self + sizeof(s);
+    return inline_storage ? 0 : s.capacity() + 1;
+}
+
+// Heap bytes of a vector and of what its elements hold.
+template <class T>
+size_t memoryBytes(const vector<T>& v) {
+    size_t bytes = v.capacity() * sizeof(T);
+    if constexpr (!is_trivially_copyable<T>::value) {
+        for (const T& x : v)
+            bytes += memoryBytes(x);
+    }
+    return bytes;
+}
+
+// Heap bytes of a hash map from strings: buckets, nodes and keys.
+template <class V>
+size_t memoryBytes(const unordered_map<string, V>& m) {
+    size_t node = sizeof(void*) + sizeof(pair<const string, V>) +
+                  sizeof(size_t);
+    size_t bytes = m.bucket_count() * sizeof(void*) + m.size() * node;
+    for (const auto& entry : m)
+        bytes += memoryBytes(entry.first);
+    return bytes;
+}
+
+// Resident set size of the process in bytes, 0 where unknown.
+inline size_t residentBytes() {
+    ifstream status("/proc/self/status");
+    string field;
+    size_t kib;
+    while (status >> field) {
+        if (field == "VmRSS:" && status >> kib)
+            return kib * 1024;
+    }
+    return 0;
+}
+
+// Bytes held by each structure of a program.
+class MemoryReport {
+private:
+    vector<pair<string, size_t>> rows;
+
+public:
+    // Adds a structure holding the given bytes.
+    void add(const string& name, size_t bytes) {
+        rows.push_back(pair<string, size_t>(name, bytes));
+    }
+
+    // Bytes of every structure added.
+    size_t total() const {
+        size_t sum = 0;
+        for (const auto& row : rows)
+            sum += row.second;
+        return sum;
+    }
+
+    /*
+     * Writes a tab separated table of the structures in the order added,
+     * with their bytes and share of the total, then the total and the
+     * resident set size of the process.
+     *
+     * Parameters:
+     *  out -
+     *      Stream to write the table to.
+     */
+    void write(ostream& out) const {
+        size_t sum = total();
+        out << "Structure\tBytes\tShare\n";
+        for (const auto& row : rows) {
+            out << row.first << '\t' << row.second << '\t' << fixed
+                << setprecision(1) << 100.0 * row.second / max(sum, (size_t)1)
+                << "%\n" << defaultfloat << setprecision(6);
+        }
+        out << "Total\t" << sum << "\t100.0%\n";
+        size_t resident = residentBytes();
+        if (resident)
+            out << "Resident set\t" << resident << "\t\n";
+    }
+};
+
+#endif  // MEMORY_HPP
@@ -0,0 +1,255 @@
+/*
+ * This file implements NeighborSets, a collection of sets of ids stored as
+ * array, bitmap or run containers. See neighborsets.hpp.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "neighborsets.hpp"
+
+using namespace std;
+
+// Size ratio from which arrays are intersected by galloping, not merging.
+const static int GALLOP_RATIO = 32;
+
+// Words of a bitmap container of a whole chunk, 2^16 ids.
+const static int BITMAP_WORDS = 1024;
+
+
+/*
+ * Appends a set, becoming set numSets() - 1.
+ *
+ * Parameters:
+ *  ids -
+ *      Ids of the set, non-negative and strictly increasing.
+ *  n -
+ *      Number of ids.
+ */
+void NeighborSets::add(const int* ids, int n) {
+    const int* last = ids + n;
+    for (const int* first = ids; first < last;) {
+        int key = *first >> 16;
+        const int* end = first;
+        while (end < last && *end >> 16 == key)
+            end++;
+        addContainer((uint16_t)key, first, end);
+        first = end;
+    }
+    set_offsets.push_back((int)containers.size());
+    set_sizes.push_back(n);
+}
+
+
+/*
+ * Adds the chunk of ids [first, last) sharing their high bits, as whichever
+ * container takes the fewest bytes, preferring runs, then arrays. Bitmaps
+ * stop at the bound on the ids.
+ */
+void NeighborSets::addContainer(uint16_t key, const int* first,
+                                const int* last) {
+    Container c;
+    c.key = key;
+    c.cardinality = (int)(last - first);
+    int runs = 0;
+    for (const int* p = first; p < last; p++)
+        runs += p == first || *p != p[-1] + 1;
+    int bitmap_words = BITMAP_WORDS;
+    if (universe > 0) {
+        long long ids = (long long)universe - ((long long)key << 16);
+        bitmap_words = (int)min((long long)BITMAP_WORDS, (ids + 63) / 64);
+    }
+
+    long long run_bytes = 4LL * runs;
+    long long array_bytes = 2LL * c.cardinality;
+    long long bitmap_bytes = 8LL * bitmap_words;
+    if (run_bytes <= min(array_bytes, bitmap_bytes)) {
+        c.kind = RUN_CONTAINER;
+        c.length = runs;
+        c.offset = shorts.size();
+        for (const int* p = first; p < last; p++) {
+            if (p == first || *p != p[-1] + 1) {
+                shorts.push_back((uint16_t)*p);
+                shorts.push_back(0);
+            } else {
+                shorts.back()++;
+            }
+        }
+    } else if (array_bytes <= bitmap_bytes) {
+        c.kind = ARRAY_CONTAINER;
+        c.length = 0;
+        c.offset = shorts.size();
+        for (const int* p = first; p < last; p++)
+            shorts.push_back((uint16_t)*p);
+    } else {
+        c.kind = BITMAP_CONTAINER;
+        c.length = bitmap_words;
+        c.offset = words.size();
+        words.resize(words.size() + bitmap_words, 0);
+        for (const int* p = first; p < last; p++) {
+            int low = *p & 0xFFFF;
+            words[c.offset + (low >> 6)] |= 1ULL << (low & 63);
+        }
+    }
+    containers.push_back(c);
+}
+
+
+// Number of ids of container c within [lo, hi] of its low 16 bits.
+int NeighborSets::countInRange(const Container& c, int lo, int hi) const {
+    if (c.kind == ARRAY_CONTAINER) {
+        const uint16_t* values = &shorts[c.offset];
+        const uint16_t* end = values + c.cardinality;
+        return (int)(upper_bound(values, end, hi) -
+                     lower_bound(values, end, lo));
+    }
+    if (c.kind == BITMAP_CONTAINER) {
+        const uint64_t* bits = &words[c.offset];
+        int count = 0;
+        hi = min(hi, 64 * c.length - 1);
+        for (int w = lo >> 6; w <= hi >> 6; w++) {
+            uint64_t word = bits[w];
+            if (w == lo >> 6)
+                word &= ~0ULL << (lo & 63);
+            if (w == hi >> 6 && (hi & 63) != 63)
+                word &= (1ULL << ((hi & 63) + 1)) - 1;
+            count += __builtin_popcountll(word);
+        }
+        return count;
+    }
+    const uint16_t* pairs = &shorts[c.offset];
+    int count = 0;
+    for (int r = 0; r < c.length; r++) {
+        int start = max(lo, (int)pairs[2 * r]);
+        int end = min(hi, pairs[2 * r] + pairs[2 * r + 1]);
+        count += max(0, end - start + 1);
+    }
+    return count;
+}
+
+
+/*
+ * Number of ids common to container a of a_sets and container b of b_sets,
+ * which share their high bits. See neighborsets.hpp for the method of each
+ * pair of representations.
+ */
+int NeighborSets::intersectContainers(const Container& a,
+                                      const NeighborSets& a_sets,
+                                      const Container& b,
+                                      const NeighborSets& b_sets) {
+    // Runs: count the other container over each run
+    if (b.kind == RUN_CONTAINER && a.kind != RUN_CONTAINER)
+        return intersectContainers(b, b_sets, a, a_sets);
+    if (a.kind == RUN_CONTAINER) {
+        const uint16_t* pairs = &a_sets.shorts[a.offset];
+        int count = 0;
+        for (int r = 0; r < a.length; r++) {
+            count += b_sets.countInRange(b, pairs[2 * r],
+                                         pairs[2 * r] + pairs[2 * r + 1]);
+        }
+        return count;
+    }
+
+    // Bitmaps: and the words, or test the ids of an array
+    if (a.kind == BITMAP_CONTAINER && b.kind == BITMAP_CONTAINER) {
+        const uint64_t* x = &a_sets.words[a.offset];
+        const uint64_t* y = &b_sets.words[b.offset];
+        int count = 0;
+        for (int w = 0; w < min(a.length, b.length); w++)
+            count += __builtin_popcountll(x[w] & y[w]);
+        return count;
+    }
+    if (a.kind == BITMAP_CONTAINER)
+        return intersectContainers(b, b_sets, a, a_sets);
+    const uint16_t* values = &a_sets.shorts[a.offset];
+    if (b.kind == BITMAP_CONTAINER) {
+        const uint64_t* bits = &b_sets.words[b.offset];
+        int count = 0;
+        for (int i = 0; i < a.cardinality; i++) {
+            int w = values[i] >> 6;
+            count += w < b.length && (bits[w] >> (values[i] & 63) & 1);
+        }
+        return count;
+    }
+
+    // Arrays: gallop through the larger if much larger, otherwise merge
+    const uint16_t* others = &b_sets.shorts[b.offset];
+    int small_size = a.cardinality, large_size = b.cardinality;
+    if (small_size > large_size) {
+        swap(values, others);
+        swap(small_size, large_size);
+    }
+    int count = 0;
+    if ((long long)small_size * GALLOP_RATIO < large_size) {
+        const uint16_t* pos = others;
+        const uint16_t* end = others + large_size;
+        for (int i = 0; i < small_size && pos < end; i++) {
+            size_t step = 1;
+            while (pos + step < end && pos[step] < values[i])
+                step *= 2;
+            pos = lower_bound(pos + step / 2, min(pos + step + 1, end),
+                              values[i]);
+            count += pos < end && *pos == values[i];
+        }
+        return count;
+    }
+    int i = 0, j = 0;
+    while (i < small_size && j < large_size) {
+        if (values[i] < others[j]) {
+            i++;
+        } else if (others[j] < values[i]) {
+            j++;
+        } else {
+            count++;
+            i++;
+            j++;
+        }
+    }
+    return count;
+}
+
+
+// Whether set s holds id.
+bool NeighborSets::contains(int s, int id) const {
+    uint16_t key = (uint16_t)(id >> 16);
+    int low = id & 0xFFFF;
+    for (int i = set_offsets[s]; i < set_offsets[s + 1]; i++) {
+        if (containers[i].key == key)
+            return countInRange(containers[i], low, low) > 0;
+    }
+    return false;
+}
+
+
+/*
+ * Number of ids common to set s of this collection and set t of other,
+ * merging their containers by high bits.
+ */
+int NeighborSets::intersectionSize(int s, const NeighborSets& other,
+                                   int t) const {
+    int i = set_offsets[s], i_end = set_offsets[s + 1];
+    int j = other.set_offsets[t], j_end = other.set_offsets[t + 1];
+    int count = 0;
+    while (i < i_end && j < j_end) {
+        const Container& a = containers[i];
+        const Container& b = other.containers[j];
+        if (a.key < b.key) {
+            i++;
+        } else if (b.key < a.key) {
+            j++;
+        } else {
+            count += intersectContainers(a, *this, b, other);
+            i++;
+            j++;
+        }
+    }
+    return count;
+}
+
+
+// Number of containers of each kind.
+void NeighborSets::kindCounts(long long counts[NUM_CONTAINER_KINDS]) const {
+    fill(counts, counts + NUM_CONTAINER_KINDS, 0);
+    for (const Container& c : containers)
+        counts[c.kind]++;
+}
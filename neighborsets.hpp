@@ -0,0 +1,163 @@
+/*
+ * This file declares NeighborSets, a collection of sets of ids, such as the
+ * co-stars of every actor, each stored in the representation suiting its
+ * size and shape (Chambi et al., "Better bitmap performance with Roaring
+ * bitmaps", 2016). A set is split by the high 16 bits of its ids into
+ * chunks, and each chunk is one of three containers of its low 16 bits:
+ *
+ *  array  - the ids in increasing order, 2 bytes each.
+ *  bitmap - a bit per possible id, at most 8 KiB. Ids are known to be under
+ *           a bound, the number of actors for co-stars, so the bitmap of the
+ *           last chunk stops at the bound: 1.5 KiB for 11794 actors.
+ *  run    - (start, length - 1) pairs of consecutive ids, 4 bytes a run.
+ *
+ * Each chunk takes the smallest, preferring runs, then arrays.
+ *
+ * So an actor with a handful of co-stars takes a few bytes, where a matrix
+ * row would take a bit per actor, and a hub is a bitmap any id is tested
+ * against in constant time. Intersections are counted container by
+ * container: array with array by merging, or by galloping through the larger
+ * when the sizes differ greatly; array with bitmap by testing each id;
+ * bitmap with bitmap by counting the bits of the words anded; runs by
+ * counting the other container over each run's range. Intersecting a small
+ * set with a hub thus costs the size of the small set, not of the hub.
+ *
+ * Every container lives in one of two pools shared by the collection, so the
+ * whole collection is a few allocations.
+ */
+
+#ifndef NEIGHBORSETS_HPP
+#define NEIGHBORSETS_HPP
+
+#include <cstdint>
+#include <vector>
+#include "memory.hpp"
+#include "sparsematrix.hpp"
+
+using namespace std;
+
+// Representations of a chunk of a set.
+enum ContainerKind : uint8_t { ARRAY_CONTAINER, BITMAP_CONTAINER,
+                               RUN_CONTAINER, NUM_CONTAINER_KINDS };
+
+class NeighborSets {
+private:
+    // Chunk of a set: high 16 bits of its ids, representation, number of
+    // ids, runs of a run container or words of a bitmap, and where its data
+    // starts in its pool. Arrays take cardinality shorts, runs 2 * length
+    // shorts and bitmaps length words.
+    struct Container {
+        uint16_t key;
+        uint8_t kind;
+        int cardinality;
+        int length;
+        size_t offset;
+    };
+
+    // Bound on the ids, 0 for none
+    int universe = 0;
+
+    // Containers of set s at containers[set_offsets[s], set_offsets[s+1])
+    vector<int> set_offsets = vector<int>(1, 0);
+    vector<int> set_sizes;
+    vector<Container> containers;
+    vector<uint16_t> shorts;
+    vector<uint64_t> words;
+
+    // Adds the chunk of ids [first, last), all with high bits key.
+    void addContainer(uint16_t key, const int* first, const int* last);
+
+    // Ids of container c within the low range [lo, hi], both included.
+    int countInRange(const Container& c, int lo, int hi) const;
+
+    // Ids common to container a of a_sets and container b of b_sets.
+    static int intersectContainers(const Container& a,
+                                   const NeighborSets& a_sets,
+                                   const Container& b,
+                                   const NeighborSets& b_sets);
+
+public:
+    // Collection of sets of ids under bound, or of any ids if bound is 0.
+    explicit NeighborSets(int bound = 0) : universe(bound) {}
+
+    /*
+     * Appends a set, becoming set numSets() - 1.
+     *
+     * Parameters:
+     *  ids -
+     *      Ids of the set, non-negative and strictly increasing.
+     *  n -
+     *      Number of ids.
+     */
+    void add(const int* ids, int n);
+
+    /*
+     * Replaces the sets with the rows of a matrix, set i holding the column
+     * indices of row i.
+     *
+     * Parameters:
+     *  matrix -
+     *      Matrix of rows with increasing column indices.
+     */
+    template <class T>
+    void build(const CsrMatrix<T>& matrix) {
+        *this = NeighborSets(matrix.cols);
+        for (int i = 0; i < matrix.rows; i++)
+            add(matrix.rowIndices(i), matrix.rowSize(i));
+    }
+
+    // Number of sets, and ids in set s.
+    int numSets() const { return (int)set_sizes.size(); }
+    int size(int s) const { return set_sizes[s]; }
+
+    // Whether set s holds id.
+    bool contains(int s, int id) const;
+
+    /*
+     * Number of ids common to set s of this collection and set t of other,
+     * which may be this collection.
+     */
+    int intersectionSize(int s, const NeighborSets& other, int t) const;
+    int intersectionSize(int s, int t) const {
+        return intersectionSize(s, *this, t);
+    }
+
+    // Calls visit(id) for every id of set s, in increasing order.
+    template <class Visit>
+    void forEach(int s, Visit visit) const {
+        for (int i = set_offsets[s]; i < set_offsets[s + 1]; i++) {
+            const Container& c = containers[i];
+            int base = (int)c.key << 16;
+            if (c.kind == ARRAY_CONTAINER) {
+                const uint16_t* values = &shorts[c.offset];
+                for (int j = 0; j < c.cardinality; j++)
+                    visit(base | values[j]);
+            } else if (c.kind == BITMAP_CONTAINER) {
+                const uint64_t* bits = &words[c.offset];
+                for (int w = 0; w < c.length; w++) {
+                    for (uint64_t word = bits[w]; word; word &= word - 1)
+                        visit(base | (w << 6 | __builtin_ctzll(word)));
+                }
+            } else {
+                const uint16_t* pairs = &shorts[c.offset];
+                for (int r = 0; r < c.length; r++) {
+                    for (int v = pairs[2 * r];
+                         v <= pairs[2 * r] + pairs[2 * r + 1]; v++)
+                        visit(base | v);
+                }
+            }
+        }
+    }
+
+    // Number of containers of each kind.
+    void kindCounts(long long counts[NUM_CONTAINER_KINDS]) const;
+
+    // Bytes held by the collection, by capacity.
+    size_t bytes() const {
+        return memoryBytes(set_offsets) + memoryBytes(set_sizes) +
+               memoryBytes(containers) + memoryBytes(shorts) +
+               memoryBytes(words);
+    }
+};
+
+#endif  // NEIGHBORSETS_HPP
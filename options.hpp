@@ -0,0 +1,136 @@
+/*
+ * This file contains the parsing of optional command line arguments shared by
+ * the programs. Options are written --name=value, or --name for a flag, and
+ * may appear anywhere on the command line. Every other argument is
+ * positional, so programs keep their documented argument order.
+ */
+
+#ifndef OPTIONS_HPP
+#define OPTIONS_HPP
+
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+/*
+ * Parses the whole of text as a decimal integer.
+ *
+ * Parameters:
+ *  text -
+ *      Digits, optionally signed.
+ *  value -
+ *      Receives the integer, unchanged if text is not one.
+ *
+ * Returns:
+ *  bool -
+ *      False if text is empty, has other characters or is out of range.
+ */
+inline bool parseInt(const string& text, int& value) {
+    char* end;
+    errno = 0;
+    long parsed = strtol(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0' || errno == ERANGE || parsed < INT_MIN ||
+        parsed > INT_MAX)
+        return false;
+    value = (int)parsed;
+    return true;
+}
+
+/*
+ * Parses the whole of text as a finite decimal number, as parseInt.
+ */
+inline bool parseDouble(const string& text, double& value) {
+    char* end;
+    errno = 0;
+    double parsed = strtod(text.c_str(), &end);
+    if (text.empty() || *end != '\0' || errno == ERANGE || !isfinite(parsed))
+        return false;
+    value = parsed;
+    return true;
+}
+
+class Options {
+private:
+    // Values of the options given, "1" for flags.
+    unordered_map<string, string> values;
+    // Arguments which are not options, in order.
+    vector<string> positional;
+
+public:
+    /*
+     * Splits argv into options and positional arguments.
+     *
+     * Parameters:
+     *  argc, argv -
+     *      Arguments of main, argv[0] is skipped.
+     *  known -
+     *      Names of the options the program accepts.
+     *  integers -
+     *      Names of the known options whose values must be integers.
+     *
+     * Returns:
+     *  bool -
+     *      False if an unknown option or an option expecting an integer
+     *      without one was given, after reporting it.
+     */
+    bool parse(int argc, char *argv[], const vector<string>& known,
+               const vector<string>& integers = {}) {
+        for (int i = 1; i < argc; i++) {
+            string arg(argv[i]);
+            if (arg.compare(0, 2, "--") != 0) {
+                positional.push_back(arg);
+                continue;
+            }
+            size_t eq = arg.find('=');
+            string name = arg.substr(2, eq == string::npos ? string::npos
+                                                           : eq - 2);
+            bool found = false;
+            for (const string& k : known)
+                found = found || k == name;
+            if (!found) {
+                cout << "Unknown option --" << name << endl;
+                return false;
+            }
+            values[name] = eq == string::npos ? "1" : arg.substr(eq + 1);
+        }
+        for (const string& name : integers) {
+            int value;
+            if (has(name) && !parseInt(get(name), value)) {
+                cout << "Option --" << name << " expects an integer, got '"
+                     << get(name) << "'" << endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Positional arguments, not including the program name.
+    const vector<string>& args() const { return positional; }
+
+    // Whether the option was given.
+    bool has(const string& name) const { return values.count(name) > 0; }
+
+    // Value of the option, or fallback if not given.
+    string get(const string& name, const string& fallback = "") const {
+        auto it = values.find(name);
+        return it == values.end() ? fallback : it->second;
+    }
+
+    // Integer value of the option, or fallback if not given or not an
+    // integer. Options checked by parse are always integers.
+    int getInt(const string& name, int fallback) const {
+        int value = fallback;
+        if (has(name))
+            parseInt(get(name), value);
+        return value;
+    }
+};
+
+#endif  // OPTIONS_HPP
@@ -0,0 +1,75 @@
+/*
+ * This file contains the small threading helpers shared by the parallel
+ * kernels. Work is split into chunks of consecutive indices which worker
+ * threads claim from a shared counter, so uneven chunks balance themselves.
+ */
+
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "trace.hpp"
+
+using namespace std;
+
+// Thread count requested through setNumThreads, 0 for the hardware default.
+inline int& requestedThreads() {
+    static int requested = 0;
+    return requested;
+}
+
+// Sets the number of threads used by parallelFor. 0 restores the default.
+inline void setNumThreads(int threads) {
+    requestedThreads() = max(0, threads);
+}
+
+// Number of threads used by parallelFor, at least 1.
+inline int numThreads() {
+    if (requestedThreads() > 0)
+        return requestedThreads();
+    return max(1, (int)thread::hardware_concurrency());
+}
+
+/*
+ * Calls body(lo, hi, thread) over chunks [lo, hi) covering [begin, end), each
+ * at most grain long, from up to numThreads() threads. thread is the index of
+ * the calling worker in [0, numThreads()), for per thread scratch space. Runs
+ * on the calling thread when one worker suffices.
+ */
+template <class Body>
+void parallelFor(int begin, int end, int grain, Body body) {
+    if (end <= begin)
+        return;
+    grain = max(1, grain);
+    int chunks = (end - begin + grain - 1) / grain;
+    int workers = min(numThreads(), chunks);
+    if (workers == 1) {
+        TRACE_SCOPE("parallel chunk");
+        body(begin, end, 0);
+        return;
+    }
+
+    atomic<int> next(begin);
+    auto work = [&](int thread) {
+        if (thread > 0)
+            TRACE_THREAD("parallel worker");
+        for (;;) {
+            int lo = next.fetch_add(grain);
+            if (lo >= end)
+                return;
+            TRACE_SCOPE("parallel chunk");
+            body(lo, min(end, lo + grain), thread);
+        }
+    };
+    vector<std::thread> pool;
+    for (int t = 1; t < workers; t++)
+        pool.emplace_back(work, t);
+    work(0);
+    for (auto& t : pool)
+        t.join();
+}
+
+#endif  // PARALLEL_HPP
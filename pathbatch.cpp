@@ -0,0 +1,198 @@
+/*
+ * This file implements the batch path engine declared in pathbatch.hpp.
+ */
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "actorgraph.hpp"
+#include "parallel.hpp"
+#include "pathbatch.hpp"
+#include "traversal.hpp"
+
+using namespace std;
+
+// One interleaved search: its labels, heap, and position. Visitor is
+// TargetVisitor, or AvoidingVisitor<TargetVisitor> when there are exclusions.
+template <class Visitor>
+struct SearchSlot {
+    SearchState state;
+    HeapFrontier<> frontier;
+    Visitor visitor;
+    optional<ResumableTraversal<HeapFrontier<>, MovieWeight, Visitor>> search;
+    // Index of the pair being searched, -1 if the slot is idle
+    int pair_index = -1;
+
+    SearchSlot(const ActorGraph& graph, const Visitor& v)
+        : state(graph), frontier(state), visitor(v) {}
+};
+
+
+// Whether the search of visitor may not start or end at actor v.
+static bool Excludes(const TargetVisitor&, int) { return false; }
+static bool Excludes(const AvoidingVisitor<TargetVisitor>& visitor, int v) {
+    return visitor.avoid->hasActor(v);
+}
+
+
+/*
+ * Starts the search for pairs[index] in slot. Returns false, with the empty
+ * path written, if either actor is unknown.
+ */
+template <class Visitor>
+static bool StartSearch(const ActorGraph& graph, SearchSlot<Visitor>& slot,
+                        const vector<pair<int, int>>& pairs, int index,
+                        vector<string>& paths) {
+    slot.pair_index = -1;
+    slot.search.reset();
+    if (pairs[index].first < 0 || pairs[index].second < 0 ||
+        Excludes(slot.visitor, pairs[index].first) ||
+        Excludes(slot.visitor, pairs[index].second)) {
+        paths[index].clear();
+        return false;
+    }
+    slot.state.reset();
+    slot.frontier.clear();
+    addSource(slot.state, slot.frontier, pairs[index].first);
+    slot.visitor.target = pairs[index].second;
+    slot.search.emplace(graph, slot.state, slot.frontier, MovieWeight(),
+                        slot.visitor);
+    slot.pair_index = index;
+    return true;
+}
+
+
+/*
+ * Runs the pairs [lo, hi) with the searches of slots, round robin one step
+ * each, refilling a slot as soon as its search ends.
+ */
+template <class Visitor>
+static void RunInterleaved(const ActorGraph& graph,
+                           vector<unique_ptr<SearchSlot<Visitor>>>& slots,
+                           const vector<pair<int, int>>& pairs, int lo,
+                           int hi, vector<string>& paths,
+                           vector<long long>* work) {
+    int next = lo;
+    int active = 0;
+
+    // Starts the next searchable pair in slot, leaving it idle if none remain
+    auto refill = [&](SearchSlot<Visitor>& slot) {
+        while (next < hi && !StartSearch(graph, slot, pairs, next, paths))
+            next++;
+        if (slot.pair_index >= 0) {
+            next++;
+            active++;
+        }
+    };
+    for (auto& slot : slots)
+        refill(*slot);
+
+    while (active) {
+        for (auto& slot : slots) {
+            if (slot->pair_index < 0 || slot->search->step())
+                continue;
+
+            // Search ended: write its path, if found, and start the next pair
+            ostringstream path;
+            if (slot->search->last() == slot->visitor.target)
+                graph.writePath(path, slot->state, slot->search->last());
+            paths[slot->pair_index] = path.str();
+            if (work)
+                (*work)[slot->pair_index] = searchWork(graph, slot->state);
+            slot->pair_index = -1;
+            active--;
+            refill(*slot);
+        }
+    }
+}
+
+
+PathSearcher::PathSearcher(const ActorGraph& g, int searches,
+                           const Exclusions* exclusions)
+    : graph(g), interleave(max(1, searches)), avoid(exclusions) {
+    AvoidingVisitor<TargetVisitor> avoiding(avoid);
+    for (int i = 0; i < interleave; i++) {
+        if (avoid)
+            avoiding_slots.emplace_back(
+                new SearchSlot<AvoidingVisitor<TargetVisitor>>(graph,
+                                                               avoiding));
+        else
+            slots.emplace_back(
+                new SearchSlot<TargetVisitor>(graph, TargetVisitor()));
+    }
+}
+
+PathSearcher::~PathSearcher() {}
+
+
+/*
+ * Finds the shortest paths of pairs [lo, hi) on the calling thread.
+ *
+ * Parameters:
+ *  pairs -
+ *      Starting and ending actor ids; -1 for an unknown actor.
+ *  lo, hi -
+ *      Range of pairs to search.
+ *  paths -
+ *      Sized for pairs; receives the path of pairs[i] at paths[i].
+ *  work -
+ *      If not null, sized for pairs; receives the roles scanned by the
+ *      search of pairs[i] at work[i], 0 for pairs not searched.
+ */
+void PathSearcher::find(const vector<pair<int, int>>& pairs, int lo, int hi,
+                        vector<string>& paths, vector<long long>* work) {
+    if (work)
+        fill(work->begin() + lo, work->begin() + hi, 0);
+    if (interleave > 1 && avoid) {
+        RunInterleaved(graph, avoiding_slots, pairs, lo, hi, paths, work);
+        return;
+    } else if (interleave > 1) {
+        RunInterleaved(graph, slots, pairs, lo, hi, paths, work);
+        return;
+    }
+    SearchState& state = avoid ? avoiding_slots[0]->state : slots[0]->state;
+    for (int i = lo; i < hi; i++) {
+        ostringstream path;
+        state.reset();
+        graph.findPath(path, pairs[i].first, pairs[i].second, state, avoid);
+        paths[i] = path.str();
+        if (work)
+            (*work)[i] = searchWork(graph, state);
+    }
+}
+
+
+/*
+ * Finds the shortest path of every pair, using numThreads() threads.
+ *
+ * Parameters:
+ *  graph -
+ *      Loaded graph, shared read only by all threads.
+ *  pairs -
+ *      Starting and ending actor ids; -1 for an unknown actor.
+ *  paths -
+ *      Receives the path of pairs[i] at paths[i], formatted as by findPath.
+ *  interleave -
+ *      Number of searches each thread interleaves. 1 runs one search at a
+ *      time with the plain traversal.
+ *  avoid -
+ *      Actors and movies no path may pass through, or null.
+ */
+void findPaths(const ActorGraph& graph, const vector<pair<int, int>>& pairs,
+               vector<string>& paths, int interleave,
+               const Exclusions* avoid) {
+    interleave = max(1, interleave);
+    int n = (int)pairs.size();
+    paths.assign(n, string());
+
+    vector<unique_ptr<PathSearcher>> searchers(numThreads());
+    parallelFor(0, n, 8 * interleave, [&](int lo, int hi, int thread) {
+        if (!searchers[thread])
+            searchers[thread].reset(
+                new PathSearcher(graph, interleave, avoid));
+        searchers[thread]->find(pairs, lo, hi, paths);
+    });
+}
@@ -0,0 +1,92 @@
+/*
+ * This file declares the batch path engine, which finds the shortest paths of
+ * many actor pairs over one shared ActorGraph. Pairs are spread over threads,
+ * and each thread may interleave several searches: every search advances a
+ * step at a time, prefetching what its next step loads, and the thread moves
+ * on to the other searches while that memory arrives. Paths are identical to
+ * those of ActorGraph findPath.
+ */
+
+#ifndef PATHBATCH_HPP
+#define PATHBATCH_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "actorgraph.hpp"
+#include "traversal.hpp"
+
+using namespace std;
+
+template <class Visitor> struct SearchSlot;
+
+/*
+ * Searches of one thread, kept between calls so their labels are allocated
+ * once. Not safe to share between threads.
+ */
+class PathSearcher {
+private:
+    const ActorGraph& graph;
+    int interleave;
+    // Exclusions of every search, or null. Only the slots checking them
+    // are made when set, and only the plain slots when null.
+    const Exclusions* avoid;
+    vector<unique_ptr<SearchSlot<TargetVisitor>>> slots;
+    vector<unique_ptr<SearchSlot<AvoidingVisitor<TargetVisitor>>>>
+        avoiding_slots;
+
+public:
+    /*
+     * Parameters:
+     *  graph -
+     *      Loaded graph, shared read only. Must outlive the searcher.
+     *  interleave -
+     *      Number of searches interleaved. 1 runs one search at a time with
+     *      the plain traversal.
+     *  avoid -
+     *      Actors and movies no path may pass through, or null. Must outlive
+     *      the searcher.
+     */
+    PathSearcher(const ActorGraph& graph, int interleave,
+                 const Exclusions* avoid = nullptr);
+    ~PathSearcher();
+
+    /*
+     * Finds the shortest paths of pairs [lo, hi) on the calling thread.
+     *
+     * Parameters:
+     *  pairs -
+     *      Starting and ending actor ids; -1 for an unknown actor.
+     *  lo, hi -
+     *      Range of pairs to search.
+     *  paths -
+     *      Sized for pairs; receives the path of pairs[i] at paths[i].
+     *  work -
+     *      If not null, sized for pairs; receives the roles scanned by the
+     *      search of pairs[i] at work[i] (see searchWork).
+     */
+    void find(const vector<pair<int, int>>& pairs, int lo, int hi,
+              vector<string>& paths, vector<long long>* work = nullptr);
+};
+
+/*
+ * Finds the shortest path of every pair, using numThreads() threads.
+ *
+ * Parameters:
+ *  graph -
+ *      Loaded graph, shared read only by all threads.
+ *  pairs -
+ *      Starting and ending actor ids; -1 for an unknown actor.
+ *  paths -
+ *      Receives the path of pairs[i] at paths[i], formatted as by findPath.
+ *  interleave -
+ *      Number of searches each thread interleaves. 1 runs one search at a
+ *      time with the plain traversal.
+ *  avoid -
+ *      Actors and movies no path may pass through, or null.
+ */
+void findPaths(const ActorGraph& graph, const vector<pair<int, int>>& pairs,
+               vector<string>& paths, int interleave,
+               const Exclusions* avoid = nullptr);
+
+#endif  // PATHBATCH_HPP
@@ -8,11 +8,24 @@
  * documentation on program use.
  */
 
+#include <algorithm>
+#include <chrono>
 #include <string>
 #include <fstream>
 #include <iostream>
-#include <sstream>
+#include <unordered_map>
+#include <vector>
 #include "actorgraph.hpp"
+#include "checkpoint.hpp"
+#include "distancesketch.hpp"
+#include "memory.hpp"
+#include "options.hpp"
+#include "parallel.hpp"
+#include "pathpipeline.hpp"
+#include "queryplanner.hpp"
+#include "trace.hpp"
+#include "traversal.hpp"
+#include "tuning.hpp"
 
 using namespace std;
 
@@ -27,11 +40,63 @@ const string USAGE = "Usage: ./pathfinder "
         "Tab delimited file of actors to find paths between. Header row "
         "expected. Rows should be formatted as starting actor, ending actor.\n"
         "\toutput_paths -\tName of file to create for output of shortest paths."
+        "\nOptions:\n\t--threads=N -\tSearch with N threads.\n"
+        "\t--interleave=G -\tInterleave G searches per thread to overlap "
+        "memory stalls.\n\t--benchmark -\tAlso time one search per thread "
+        "and report the speedup of interleaving.\n"
+        "\t--checkpoint=N -\tFlush output and record progress every N pairs."
+        "\n\t--resume -\tContinue from the progress recorded by an earlier "
+        "run.\n\t--batch=B -\tHand pairs to the search threads B at a time."
+        "\n\t--queue=Q -\tQueue at most Q batches between stages."
+        "\n\t--mode=M -\tpath for the shortest path of each pair, "
+        "steiner for a tree connecting all actors of each row, or meet-sum or "
+        "meet-max for the actor fewest hops in sum or at most from them, "
+        "distance for the length of the shortest path of each pair, or "
+        "estimate for its approximate hops."
+        "\n\t--sketches=K -\tDraw K seed sets of each size for estimates "
+        "and planning."
+        "\n\t--plan-log=F -\tLog the engine chosen for each pair, with its "
+        "estimated and actual cost, to file F."
+        "\n\t--avoid-actors=F -\tAnswer without passing through the actors "
+        "named in file F, one per row after a header row."
+        "\n\t--avoid-movies=F -\tAnswer without passing through the movies "
+        "of file F, rows of title and year after a header row."
+        "\n\t--memory -\tReport the bytes held by each structure once built."
         ;
 const string ERROR_ARG = " called with incorrect arguments.";
 const string ERROR_PARAM = "Wrong parameter, must be u or w";
+const string ERROR_MODE = 
+    "Wrong mode, must be path, steiner, meet-sum, meet-max, estimate or "
+    "distance";
 const string ERROR_READ_1 = "Error reading actors tsv file.";
 const string ERROR_READ_2 = "Error reading pairs file or opening output file.";
+const string ERROR_READ_3 = "Error reading actors or movies to avoid.";
+const string ERROR_RESUME = 
+    "Checkpoint records another graph, pairs file, weighting or mode, "
+    "not resuming.";
+
+// Default number of searches interleaved per thread
+const int DEFAULT_INTERLEAVE = 1;
+
+// Default number of seed sets of each size sketched for estimates
+const int DEFAULT_SKETCHES = 2;
+
+// Names of the query modes and the output header of each
+const vector<string> MODE_NAMES = {"path", "steiner", "meet-sum", 
+                                   "meet-max", "estimate", "distance"};
+const vector<string> MODE_HEADERS = {
+    "(actor)--[movie#@year]-->(actor)--...",
+    "(actor)--[movie#@year]-->(actor)\t...",
+    "(actor)\thops sum\thops max\thops to each",
+    "(actor)\thops sum\thops max\thops to each",
+    "hops estimate",
+    "distance"};
+
+// Function declarations for main
+static double TimePaths(const ActorGraph&, istream&, size_t,
+                        const PipelineOptions&, const PathSink&);
+static bool ReadExclusions(const ActorGraph&, const string&, const string&,
+                           Exclusions&);
 
 /* 
  * Parses command line arguments and pairs file to obtain pairs to find the
@@ -50,37 +115,157 @@ const string ERROR_READ_2 = "Error reading pairs file or opening output file.";
  *      Rows should be formatted as starting actor, ending actor. 
  *  argv[4] - out_paths
  *      Name of file to create for output of shortest paths. 
+ *  --threads=N
+ *      Optional number of threads to search with. 
+ *  --interleave=G
+ *      Optional number of searches each thread interleaves. 
+ *  The threads, searches interleaved, batch size and the planner's time per
+ *  role of each engine default to those tuned by the analyzer's autotune 
+ *  mode, if data.tsv.tune holds a tuning of data.tsv on this host. 
+ *  --benchmark
+ *      Also times one search per thread, reporting the interleaving speedup.
+ *  --checkpoint=N
+ *      Optionally flushes the paths and records progress every N pairs in
+ *      out_paths.ckpt.
+ *  --resume
+ *      Continues from out_paths.ckpt if present, keeping the paths already
+ *      written.
+ *  --batch=B
+ *      Optional number of pairs handed to a search thread at once.
+ *  --queue=Q
+ *      Optional number of batches queued between pipeline stages.
+ *  --mode=M
+ *      Optional query of each row: path (default) for the shortest path
+ *      between its two actors, steiner for a tree of movies connecting all
+ *      of its actors, or meet-sum or meet-max for the actor fewest hops from
+ *      all of them in sum or at most, distance for the length of the
+ *      shortest path between its two actors, or estimate for its
+ *      approximate hops from distance sketches. Queries between two actors
+ *      are answered by the engine the query planner chooses.
+ *  --sketches=K
+ *      Optional number of seed sets of each size sketched. Sketches are
+ *      built for estimates, or for any mode if K is given, and also guide
+ *      the planner.
+ *  --plan-log=F
+ *      Optional file receiving the engine chosen for each pair, with its
+ *      estimated and actual roles scanned.
+ *  --avoid-actors=F
+ *      Optional file of actors, one per row after a header row, which no
+ *      path, tree or meeting point may pass through.
+ *  --avoid-movies=F
+ *      Optional file of movies, rows of title and year after a header row,
+ *      which no path, tree or meeting point may pass through.
+ *  --memory
+ *      Reports the bytes held by the graph, exclusions, sketches and planner
+ *      statistics once built.
  *
  * Return: 
  *  int - 
  *      Exit status. -1 for unsuccessful reading or parsing, 0 otherwise. 
  */
 int main(int argc, char *argv[]) {
+    TRACE_FILE(string(argv[0]) + ".trace.json");
+    TRACE_THREAD("main");
+    // Split options from arguments
+    Options options;
+    if (!options.parse(argc, argv, {"threads", "interleave", "benchmark",
+                                      "checkpoint", "resume", "batch",
+                                      "queue", "mode", "avoid-actors",
+                                      "avoid-movies", "sketches",
+                                      "plan-log", "memory"},
+                       {"threads", "interleave", "checkpoint", "batch",
+                        "queue", "sketches"})) {
+        cout << USAGE << endl; 
+        return -1; 
+    }
+    const vector<string>& args = options.args();
+
     // Check correct number commandline args
-    if (argc != 5) { 
+    if (args.size() != 4) { 
         cout << argv[0] << ERROR_ARG << endl;
         cout << USAGE << endl; 
         return -1; 
     }
     // Check weighted edge parameter
-    if (*argv[2] != 'u' && *argv[2] != 'w') { 
+    if (args[1] != "u" && args[1] != "w") { 
         cout << ERROR_PARAM << endl;
         cout << USAGE << endl; 
         return -1; 
     }
+    // Read the parameters tuned for the graph on this host, if any
+    Tuning tuning(args[0]);
+    if (tuning.load())
+        cout << "Using parameters tuned in " << tuning.file() << " ..." 
+             << endl;
+    setNumThreads(options.getInt("threads", tuning.getInt("threads", 0)));
+    int interleave = options.getInt("interleave", 
+                                    tuning.getInt("interleave", 
+                                                  DEFAULT_INTERLEAVE));
+    int checkpoint_every = options.getInt("checkpoint", 0);
+    int mode = find(MODE_NAMES.begin(), MODE_NAMES.end(), 
+                    options.get("mode", "path")) - MODE_NAMES.begin();
+    if (mode == (int)MODE_NAMES.size()) { 
+        cout << ERROR_MODE << endl;
+        cout << USAGE << endl; 
+        return -1; 
+    }
 
     // Create ActorGraph object to find shortest paths between actors.
     ActorGraph graph; 
 
     // Call loadFromFile to initialize ActorGraph, exiting if unsuccessful read.
-    if (!graph.loadFromFile(argv[1], (*argv[2] == 'w') ? true : false)) {
+    if (!graph.loadFromFile(args[0].c_str(), args[1] == "w")) {
         cout << ERROR_READ_1 << endl;
         return -1; 
     } 
-    // Set up file streams for output and pairs 
-    ifstream pairs(argv[3]);
-    ofstream output(argv[4]); 
-    if (!pairs || !output) { 
+    // Mark the actors and movies to avoid, checked by every search 
+    Exclusions avoid(graph);
+    bool avoiding = options.has("avoid-actors") || options.has("avoid-movies");
+    if (avoiding && !ReadExclusions(graph, options.get("avoid-actors", ""),
+                                    options.get("avoid-movies", ""), avoid)) {
+        cout << ERROR_READ_3 << endl;
+        return -1;
+    }
+
+    // Sketch the graph for estimates, once for all pairs 
+    DistanceSketch sketch;
+    bool sketched = mode == ESTIMATE_QUERY || options.has("sketches");
+    if (sketched) { 
+        auto start = chrono::steady_clock::now();
+        sketch.build(graph, options.getInt("sketches", DEFAULT_SKETCHES));
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - 
+                                           start;
+        cout << "Sketched " << sketch.numSets() << " seed sets in " 
+             << elapsed.count() << "s (" << sketch.bytes() / 1024 
+             << " KiB) ..." << endl;
+    }
+
+    // Gather the statistics the planner chooses engines by 
+    PlannerIndex index;
+    index.build(graph, args[1] == "w", sketched ? &sketch : nullptr);
+    for (int e = 0; e < NUM_ENGINES; e++) 
+        index.scale[e] = tuning.get(string("planner-") + ENGINE_NAMES[e], 1);
+    if (args[1] == "w") 
+        index.bucket_width = tuning.getInt("bucket-width", 1);
+    if (options.has("memory")) { 
+        MemoryReport memory;
+        graph.memoryUsage(memory);
+        if (avoiding) 
+            memory.add("exclusions", avoid.bytes());
+        if (sketched) 
+            memory.add("distance sketches", sketch.bytes());
+        memory.add("planner index", index.bytes());
+        memory.write(cout);
+    }
+    PlanLog plan_log;
+    if (options.has("plan-log") && !plan_log.open(options.get("plan-log"))) { 
+        cout << ERROR_READ_2 << endl;
+        return -1;
+    }
+
+    // Set up file stream for pairs 
+    ifstream pairs(args[2]);
+    if (!pairs) { 
         cout << ERROR_READ_2 << endl;
         return -1;
     }
@@ -88,27 +273,197 @@ int main(int argc, char *argv[]) {
     // Skip header of pairs file 
     string line; 
     getline(pairs, line);
+    streampos first_pair = pairs.tellg();
+
+    // Open output, continuing after the pairs done by an earlier run 
+    string settings = args[1] + " mode=" + MODE_NAMES[mode] + 
+                      " avoid-actors=" + options.get("avoid-actors") + 
+                      " avoid-movies=" + options.get("avoid-movies");
+    Checkpoint checkpoint(args[3], args[2], args[0], settings);
+    if (options.has("resume") && checkpoint.load()) { 
+        cout << "Resuming after " << checkpoint.done << " pairs ..." << endl;
+    } else if (checkpoint.mismatch) { 
+        cout << ERROR_RESUME << endl;
+        return -1;
+    }
+    ofstream output;
+    if (!checkpoint.open(output, args[3])) { 
+        cout << ERROR_READ_2 << endl;
+        return -1;
+    }
     // Write header to output file 
-    output << "(actor)--[movie#@year]-->(actor)--...\n";
-
-    // Read from pairs file, call ActorGraph findPath to find shortest path
-    while (getline(pairs, line)) { 
-        // Get two names from string
-        istringstream ss(line);
-        string next;
-        vector<string> name_pairs;
-        while (getline(ss, next, '\t')) {
-            name_pairs.push_back(next);
+    if (checkpoint.done == 0) 
+        output << MODE_HEADERS[mode] << "\n";
+
+    // Write paths in order of the pairs file, recording progress once at
+    // least checkpoint_every pairs are done since the last checkpoint
+    size_t saved = checkpoint.done;
+    PathSink write = [&](const vector<string>& paths, size_t done) { 
+        for (const string& path : paths) { 
+            output << path << "\n";    
         }
+        if (checkpoint_every > 0 && done - saved >= (size_t)checkpoint_every) {
+            checkpoint.save(output, done);
+            saved = done;
+        }
+    };
+
+    // Stream all pairs through the pipeline, reporting throughput
+    PipelineOptions pipeline;
+    pipeline.mode = (QueryMode)mode;
+    pipeline.batch = options.getInt("batch", 
+                                    tuning.getInt("batch", pipeline.batch));
+    pipeline.queue = options.getInt("queue", pipeline.queue);
+    pipeline.interleave = interleave;
+    pipeline.avoid = avoiding ? &avoid : nullptr;
+    pipeline.index = &index;
+    if (options.has("benchmark") && interleave > 1) { 
+        pipeline.interleave = 1;
+        double single = TimePaths(graph, pairs, checkpoint.done, pipeline,
+                                  [](const vector<string>&, size_t) {});
+        pairs.clear();
+        pairs.seekg(first_pair);
+        pipeline.interleave = interleave;
+        pipeline.plan_log = &plan_log;
+        double interleaved = TimePaths(graph, pairs, checkpoint.done, 
+                                       pipeline, write);
+        cout << "Interleaving speedup: " << interleaved / single << "x" 
+             << endl;
+    } else { 
+        pipeline.plan_log = &plan_log;
+        TimePaths(graph, pairs, checkpoint.done, pipeline, write);
+    }
 
-        // Find path and writes to file
-        graph.findPath(output, name_pairs[0], name_pairs[1]);
-        output << "\n";    
+    // Report the engines chosen and the accuracy of their estimated costs
+    for (int e = 0; e < NUM_ENGINES; e++) { 
+        if (!plan_log.queries[e]) 
+            continue;
+        cout << "Planned " << ENGINE_NAMES[e] << " for " 
+             << plan_log.queries[e] << " pairs, estimated " 
+             << plan_log.estimated[e] << " roles, scanned " 
+             << plan_log.actual[e] << endl;
     }
 
-    // Close all files 
+    // Close all files, the batch being finished
     pairs.close();
     output.close();
+    if (output) 
+        checkpoint.remove();
 
     return 0;
 }
+
+
+/* 
+ * Finds the paths of the pairs after the first skipped with the streaming 
+ * pipeline, reporting the time taken, throughput and queue statistics. 
+ *
+ * Parameters: 
+ *  graph - 
+ *      Loaded graph. 
+ *  pairs - 
+ *      Pairs file positioned after its header. 
+ *  skip - 
+ *      Number of pairs already done, which are skipped. 
+ *  pipeline - 
+ *      Sizes of the pipeline. 
+ *  sink - 
+ *      Receives the paths of each batch in order. 
+ *
+ * Return: 
+ *  double - 
+ *      Throughput in paths per second. 
+ */
+static double TimePaths(const ActorGraph& graph, istream& pairs, size_t skip,
+                        const PipelineOptions& pipeline, 
+                        const PathSink& sink) { 
+    PipelineStats stats = streamPaths(graph, pairs, skip, pipeline, sink);
+
+    double throughput = stats.pairs / max(stats.seconds, 1e-9);
+    cout << "Found " << stats.pairs << " paths in " << stats.seconds 
+         << "s with " << numThreads() << " threads x " 
+         << pipeline.interleave << " searches (" << throughput 
+         << " paths/s)" << endl;
+    const QueueStats& in = stats.input;
+    const QueueStats& out = stats.output;
+    cout << "Pair queue depth " << in.mean_depth << " mean, " << in.max_depth
+         << " max; reader waited " << in.push_wait << "s, workers waited " 
+         << in.pop_wait << "s" << endl;
+    cout << "Path queue depth " << out.mean_depth << " mean, " 
+         << out.max_depth << " max; workers waited " << out.push_wait 
+         << "s, writer waited " << out.pop_wait << "s, held " 
+         << stats.max_held << " batches" << endl;
+    cout << "Bottleneck: " << pipelineBottleneck(stats) << endl;
+    return throughput;
+}
+
+
+/* 
+ * Marks the actors and movies listed in files as excluded from every search.
+ * Unknown names are counted but otherwise ignored. 
+ *
+ * Parameters: 
+ *  graph - 
+ *      Loaded graph. 
+ *  actors_file - 
+ *      File of actor names, one per row after a header row, or empty. 
+ *  movies_file - 
+ *      File of movies, rows of title and year after a header row, or empty. 
+ *  avoid - 
+ *      Exclusions of graph to mark. 
+ *
+ * Return: 
+ *  bool - 
+ *      False if a named file could not be read, true otherwise. 
+ */
+static bool ReadExclusions(const ActorGraph& graph, const string& actors_file,
+                           const string& movies_file, Exclusions& avoid) { 
+    string line;
+    int actors = 0, movies = 0, unknown = 0;
+    if (!actors_file.empty()) { 
+        ifstream in(actors_file);
+        if (!in) 
+            return false;
+        getline(in, line);
+        while (getline(in, line)) { 
+            if (line.empty()) 
+                continue;
+            int id = graph.actorId(line.substr(0, line.find('\t')));
+            if (id < 0) { 
+                unknown++;
+                continue;
+            }
+            avoid.excludeActor(id);
+            actors++;
+        }
+    }
+    if (!movies_file.empty()) { 
+        ifstream in(movies_file);
+        if (!in) 
+            return false;
+        // Movies are named title#@year in the graph
+        unordered_map<string, int> movie_ids;
+        for (int m = 0; m < graph.numMovies(); m++) { 
+            movie_ids.emplace(graph.movieTitle(m), m);
+        }
+        getline(in, line);
+        while (getline(in, line)) { 
+            if (line.empty()) 
+                continue;
+            size_t tab = line.find('\t');
+            string title = line.substr(0, tab);
+            if (tab != string::npos) 
+                title += "#@" + line.substr(tab + 1);
+            auto found = movie_ids.find(title);
+            if (found == movie_ids.end()) { 
+                unknown++;
+                continue;
+            }
+            avoid.excludeMovie(found->second);
+            movies++;
+        }
+    }
+    cout << "Avoiding " << actors << " actors and " << movies << " movies (" 
+         << unknown << " unknown) ..." << endl;
+    return true;
+}
@@ -0,0 +1,255 @@
+/*
+ * This file implements the streaming path pipeline declared in
+ * pathpipeline.hpp.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "actorgraph.hpp"
+#include "boundedqueue.hpp"
+#include "groupquery.hpp"
+#include "parallel.hpp"
+#include "pathbatch.hpp"
+#include "pathpipeline.hpp"
+#include "queryplanner.hpp"
+#include "trace.hpp"
+
+using namespace std;
+
+// Batch of rows read as actor ids, numbered in file order.
+struct RowBatch {
+    size_t seq = 0;
+    size_t first_row = 0;     // row of the file after the header
+    vector<vector<int>> rows;
+};
+
+// Paths of the batch of rows with the same number.
+struct PathBatch {
+    size_t seq = 0;
+    vector<string> paths;
+};
+
+
+// Actor ids of the tab separated names of a row, -1 for unknown actors.
+static vector<int> ParseRow(const ActorGraph& graph, const string& line) {
+    istringstream ss(line);
+    string next;
+    vector<int> ids;
+    while (getline(ss, next, '\t')) {
+        ids.push_back(graph.actorId(next));
+    }
+    return ids;
+}
+
+
+/*
+ * Answers the queries of a batch of rows into paths, with the searchers of
+ * the calling worker. The planner and group searcher are created on first
+ * use.
+ */
+static void AnswerRows(const ActorGraph& graph, const RowBatch& in,
+                       const PipelineOptions& options, PathSearcher& searcher,
+                       unique_ptr<QueryPlanner>& planner,
+                       unique_ptr<GroupSearcher>& group,
+                       vector<string>& paths) {
+    int n = (int)in.rows.size();
+    paths.assign(n, string());
+    if (options.mode == PATH_QUERY || options.mode == DISTANCE_QUERY ||
+        options.mode == ESTIMATE_QUERY) {
+        // Pairs of the first two names, (-1, -1) for rows with fewer
+        vector<pair<int, int>> pairs(n, pair<int, int>(-1, -1));
+        for (int i = 0; i < n; i++) {
+            if (in.rows[i].size() >= 2)
+                pairs[i] = pair<int, int>(in.rows[i][0], in.rows[i][1]);
+        }
+        if (!options.index) {
+            searcher.find(pairs, 0, n, paths);
+            return;
+        }
+        if (!planner)
+            planner.reset(new QueryPlanner(graph, *options.index,
+                                           options.avoid, searcher));
+        PairQuery query = options.mode == PATH_QUERY ? PATH_PAIR
+                        : options.mode == DISTANCE_QUERY ? DISTANCE_PAIR
+                                                         : ESTIMATE_PAIR;
+        planner->answer(query, pairs, paths, options.plan_log, in.first_row);
+        return;
+    }
+    if (!group)
+        group.reset(new GroupSearcher(graph, options.avoid));
+    for (int i = 0; i < n; i++) {
+        ostringstream out;
+        if (options.mode == STEINER_QUERY)
+            group->steinerTree(out, in.rows[i]);
+        else
+            group->meetingPoint(out, in.rows[i],
+                                options.mode == MEET_MAX_QUERY);
+        paths[i] = out.str();
+    }
+}
+
+
+/*
+ * Answers every row of a pairs file, with numThreads() workers.
+ *
+ * Parameters:
+ *  graph -
+ *      Loaded graph, shared read only by the workers.
+ *  pairs -
+ *      Pairs file positioned after its header.
+ *  skip -
+ *      Number of leading rows already done, read but not searched.
+ *  options -
+ *      Query mode and sizes of the pipeline.
+ *  sink -
+ *      Called on the calling thread with each batch of answers, in order.
+ *
+ * Returns:
+ *  PipelineStats -
+ *      Time taken and queue statistics.
+ */
+PipelineStats streamPaths(const ActorGraph& graph, istream& pairs,
+                          size_t skip, const PipelineOptions& options,
+                          const PathSink& sink) {
+    auto begin = chrono::steady_clock::now();
+    PipelineStats stats;
+    stats.workers = numThreads();
+    size_t batch = max(1, options.batch);
+    size_t capacity = options.queue > 0 ? options.queue : 4 * stats.workers;
+    BoundedQueue<RowBatch> input(capacity);
+    BoundedQueue<PathBatch> output(capacity);
+
+    // Reorder window: batch seq is read only once seq < released, which the
+    // writer keeps capacity batches past the next batch to write, so fewer
+    // than capacity batches are ever held back
+    mutex window_lock;
+    condition_variable window_open;
+    size_t released = capacity;
+    auto await_window = [&](size_t seq) {
+        unique_lock<mutex> guard(window_lock);
+        if (seq >= released) {
+            TRACE_SCOPE("window full");
+            window_open.wait(guard, [&] { return seq < released; });
+        }
+    };
+
+    // Reader: parse batches of rows after those skipped
+    thread reader([&] {
+        TRACE_THREAD("pipeline reader");
+        TRACE_BEGIN("read batch");
+        string line;
+        size_t skipped = 0;
+        RowBatch next;
+        next.first_row = skip;
+        while (getline(pairs, line)) {
+            if (skipped < skip) {
+                skipped++;
+                continue;
+            }
+            next.rows.push_back(ParseRow(graph, line));
+            if (next.rows.size() == batch) {
+                size_t seq = next.seq;
+                size_t row = next.first_row + next.rows.size();
+                TRACE_END("read batch");
+                await_window(seq);
+                input.push(move(next));
+                TRACE_BEGIN("read batch");
+                next = RowBatch();
+                next.seq = seq + 1;
+                next.first_row = row;
+            }
+        }
+        TRACE_END("read batch");
+        if (!next.rows.empty()) {
+            await_window(next.seq);
+            input.push(move(next));
+        }
+        input.close();
+    });
+
+    // Workers: answer a batch at a time, the last closing output
+    atomic<int> running(stats.workers);
+    vector<thread> workers;
+    for (int w = 0; w < stats.workers; w++) {
+        workers.emplace_back([&] {
+            TRACE_THREAD("pipeline worker");
+            PathSearcher searcher(graph, options.interleave, options.avoid);
+            unique_ptr<QueryPlanner> planner;
+            unique_ptr<GroupSearcher> group;
+            RowBatch in;
+            while (input.pop(in)) {
+                PathBatch out;
+                out.seq = in.seq;
+                TRACE_SCOPE("answer batch");
+                AnswerRows(graph, in, options, searcher, planner, group,
+                           out.paths);
+                output.push(move(out));
+            }
+            if (--running == 0)
+                output.close();
+        });
+    }
+
+    // Writer: hand on batches in order, holding back those finished early
+    map<size_t, vector<string>> held;
+    size_t next_seq = 0;
+    size_t done = skip;
+    PathBatch out;
+    while (output.pop(out)) {
+        held[out.seq].swap(out.paths);
+        stats.max_held = max(stats.max_held, held.size() - 1);
+        while (!held.empty() && held.begin()->first == next_seq) {
+            done += held.begin()->second.size();
+            stats.pairs += held.begin()->second.size();
+            TRACE_SCOPE("write batch");
+            sink(held.begin()->second, done);
+            held.erase(held.begin());
+            next_seq++;
+            {
+                lock_guard<mutex> guard(window_lock);
+                released = next_seq + capacity;
+            }
+            window_open.notify_one();
+        }
+    }
+
+    reader.join();
+    for (auto& w : workers)
+        w.join();
+    stats.input = input.statistics();
+    stats.output = output.statistics();
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - begin;
+    stats.seconds = elapsed.count();
+    return stats;
+}
+
+
+/*
+ * Names the stage limiting a run from its queue statistics, the one its
+ * neighbors waited on longest: the reader by the average worker's wait on an
+ * empty input queue, the writer by its wait on a full output queue, and the
+ * workers by the reader's wait on a full input queue or the writer's on an
+ * empty output queue, less what the workers themselves waited for input.
+ * Ties go to the workers, and "none" is named if no stage waited.
+ */
+string pipelineBottleneck(const PipelineStats& stats) {
+    int workers = max(1, stats.workers);
+    double reader = stats.input.pop_wait / workers;
+    double writer = stats.output.push_wait / workers;
+    double searchers = max(stats.input.push_wait,
+                           stats.output.pop_wait - reader);
+    if (max(searchers, max(reader, writer)) <= 0)
+        return "none";
+    if (searchers >= reader && searchers >= writer)
+        return "search workers";
+    return writer >= reader ? "writer" : "reader";
+}
@@ -0,0 +1,106 @@
+/*
+ * This file declares the streaming path pipeline, which finds the paths of a
+ * pairs file of any length in constant memory. Three stages run at once,
+ * joined by bounded queues:
+ *
+ *  reader  - parses batches of rows from the file into actor ids.
+ *  workers - one per thread, each answering the rows of a batch at a time.
+ *  writer  - hands the batches of answers on in file order, holding back
+ *            those finished early.
+ *
+ * Rows are answered by the query mode of the run: the shortest path, its
+ * length or an estimate of its hops between the two actors of each row,
+ * each by the engine the query planner chooses (see queryplanner.hpp), the
+ * tree connecting all of its actors, or the actor closest to all of them
+ * (see groupquery.hpp).
+ *
+ * A full queue stalls the stage feeding it, and the reader waits to read a
+ * batch until it is within a queue's capacity of the next batch to write,
+ * so a slow batch holds the writer back by fewer batches than a queue holds.
+ * At most the queued batches, one per worker and those held back are in
+ * memory at once, however long the file.
+ * The statistics of each queue show which stage limits throughput.
+ */
+
+#ifndef PATHPIPELINE_HPP
+#define PATHPIPELINE_HPP
+
+#include <functional>
+#include <istream>
+#include <string>
+#include <vector>
+#include "actorgraph.hpp"
+#include "boundedqueue.hpp"
+#include "queryplanner.hpp"
+#include "traversal.hpp"
+
+using namespace std;
+
+// Queries a row of the pairs file may ask.
+enum QueryMode { PATH_QUERY, STEINER_QUERY, MEET_SUM_QUERY, MEET_MAX_QUERY,
+                 ESTIMATE_QUERY, DISTANCE_QUERY };
+
+// Query mode and sizes of the pipeline.
+struct PipelineOptions {
+    QueryMode mode = PATH_QUERY;
+    int batch = 64;       // rows per batch
+    int queue = 0;        // batches per queue, 0 for four per worker
+    int interleave = 1;   // searches interleaved by each worker
+    // Actors and movies no answer may pass through, or null
+    const Exclusions* avoid = nullptr;
+    // Statistics and indexes planning the queries between two actors, and
+    // the log of the plans, or null. Path queries without an index go
+    // straight to the path searcher.
+    const PlannerIndex* index = nullptr;
+    PlanLog* plan_log = nullptr;
+};
+
+// Statistics of a pipeline run.
+struct PipelineStats {
+    size_t pairs = 0;         // rows answered, not counting skipped ones
+    int workers = 0;
+    double seconds = 0;
+    QueueStats input;         // batches of pairs, reader to workers
+    QueueStats output;        // batches of paths, workers to writer
+    size_t max_held = 0;      // most batches the writer held back
+};
+
+// Receives the answers of a batch in file order, and the number of rows done
+typedef function<void(const vector<string>&, size_t)> PathSink;
+
+/*
+ * Answers every row of a pairs file, with numThreads() workers.
+ *
+ * Parameters:
+ *  graph -
+ *      Loaded graph, shared read only by the workers.
+ *  pairs -
+ *      Pairs file positioned after its header. Rows are tab separated actor
+ *      names: starting actor, ending actor for paths, where rows without two
+ *      names get an empty path, or any number of actors for group queries.
+ *  skip -
+ *      Number of leading rows already done, read but not searched.
+ *  options -
+ *      Query mode and sizes of the pipeline.
+ *  sink -
+ *      Called on the calling thread with each batch of answers, in order.
+ *
+ * Returns:
+ *  PipelineStats -
+ *      Time taken and queue statistics.
+ */
+PipelineStats streamPaths(const ActorGraph& graph, istream& pairs,
+                          size_t skip, const PipelineOptions& options,
+                          const PathSink& sink);
+
+/*
+ * Names the stage limiting a run from its queue statistics, the one its
+ * neighbors waited on longest: the reader by the average worker's wait on an
+ * empty input queue, the writer by its wait on a full output queue, and the
+ * workers by the reader's wait on a full input queue or the writer's on an
+ * empty output queue, less what the workers themselves waited for input.
+ * Ties go to the workers, and "none" is named if no stage waited.
+ */
+string pipelineBottleneck(const PipelineStats& stats);
+
+#endif  // PATHPIPELINE_HPP
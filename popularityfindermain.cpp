@@ -1,204 +1,213 @@
-/*
- * This file fully contains the methods necessary to run the popularityfinder
- * program, which finds actors of a certain popularity through k-core graph
- * decomposition.
- */
-
-#include <algorithm>
-#include <string>
-#include <sstream>
-#include <iostream>
-#include <fstream>
-#include <unordered_map>
-#include <vector>
-
-using namespace std;
-
-// Usage string
-const static string USAGE = 
-    "./popularityfinder called with "
-    "incorrect arguments.\nUsage: ./popularityfinder "
-    "data.tsv k pop_actors\n";
-
-// Function declarations for main
-static void BuildStructures(ifstream&);
-
-// Bidirectional map for string <-> int conversions for matrix 
-static unordered_map<string, int> name_to_int; 
-static vector<string> int_to_name;
-
-// Names of actors to find 
-static vector<string> actors; 
-
-// Adjacency matrix for graph that holds actor connections. [i][j] = connection
-// from actor i to actor j. 
-static vector<vector<int>> graph; 
-
-// Holds count of each actor
-static vector<int> counts;
-
-/*
- * Runs the popularityfinder program, performing k-core graph decomposition
- * based on passed k. Edges between actors based on mutual movies. 
- *
- * Parameters: 
- *  argv[1] - data.tsv
- *      Tab delimited file of movie actor relationships. Header row expected.
- *      Rows should be formatted as actor name, movie title, and movie year.
- *  argv[2] - k
- *      The minimum number of connections between actors to remain in the output
- *      file. The target used for k-core decomposition.
- *  argv[3] - pop_actors 
- *      The output file name of actors popular enough, with at least k 
- *      connections. 
- */
-int main(int argc, char *argv[]) {
-    // Check number of cmdline args
-    if (argc != 4) { 
-        cout << USAGE; 
-        return -1;
-    }
-
-    // Open files and save min num
-    ifstream tsv_file(argv[1]);
-    int k = stoi(argv[2]);
-    ofstream out_file(argv[3]);
-
-    // Check proper file opening
-    if (!tsv_file || !out_file) { 
-        cout << "Error opening file!" << endl;
-        return -1;
-    }
-
-    // Create structures
-    BuildStructures(tsv_file);
-
-    bool not_done = true;
-    // Perform k-core pruning
-    while (not_done) {
-        cout << "Pruning...\n";
-        not_done = false;
-        // Remove vertices lower than count
-        for (int i = 0; i < (int)counts.size(); i++) {
-            // If vertex lower than count and not already deleted
-            if (counts[i] < k && counts[i] > -(int)counts.size()) {
-                not_done = true;
-                // Deinc each neighbor of vertex i
-                for (int j = 0; j < (int)counts.size(); j++) {
-                    if (graph[i][j])
-                        counts[j]--;
-                }
-                // Set vertex to 'deleted', with negative counts
-                counts[i] = -(int)counts.size();
-            }
-        }
-    }
-
-
-    // Keep actors with greater than k connections
-    vector<string> names;
-    for (int i = 0; i < (int)counts.size(); i++) { 
-        if (counts[i] >= k)
-            names.push_back(int_to_name[i]);
-    }
-
-    // Sort the actors alphabetically by name 
-    sort(names.begin(), names.end());
-
-    out_file << "Actor\n";
-    for (string s : names) { 
-        out_file << s << '\n';
-    }
-
-    tsv_file.close();
-    out_file.close();
-
-    return 0;
-}
-
-
-/*
- * Builds adjacency matrix and bidirectional map for matrix access.
- * Modifies graph, name_to_int, and int_to_name. 
- * 
- * Params
- *  tsv - 
- *      Input file of actors and their movies. Assumes tsv file is 3 columns,
- *      with a header. First column contains actor name, second movie, third
- *      movie year. 
- *      Used to build graph, name_to_int, int_to_name
- */ 
-static void BuildStructures(ifstream& tsv_file) { 
-
-    // Holds the next line when reading in the file
-    string line;
-
-    // Discard the header
-    getline(tsv_file, line); 
-
-    // Temporary data structure to build adjacency matrix, maps movies to actors
-    unordered_map<string, vector<string>> movie_to_actor;
-
-    // Read in the tsv file, ending when EOF reached
-    while (getline(tsv_file, line)) {
-        // Tokenize the line into strings 
-        istringstream ss(line);
-        vector<string> record;
-        // Parse the line by tabs, storing each word in record 
-        string next; 
-        while (getline(ss, next, '\t')) {
-                record.push_back(next);
-        }
-
-        string actor_name(record[0]);
-        string movie_title(record[1].append(record[2]));
-
-        // Build name_to_int, int_to_name
-        if (!name_to_int.count(actor_name)) { 
-            name_to_int[actor_name] = int_to_name.size();
-            int_to_name.push_back(actor_name);
-        }
-
-        // Build temporary data structure which maps movies to actors
-        if (!movie_to_actor.count(movie_title)) { 
-            movie_to_actor[movie_title] = vector<string>();
-        }
-        movie_to_actor[movie_title].push_back(actor_name);
-
-    }
-    cout << "Finished reading tsv..." << endl; 
-
-    // Create adjacency matrix of correct size
-    graph = vector<vector<int>>(int_to_name.size(), 
-        vector<int>(int_to_name.size(), 0));
-    
-
-    // Create adjacency matrix from movie_to_actor 
-    for (auto pair : movie_to_actor) { 
-        vector<string>& actors = pair.second; 
-        int size = (int) actors.size();
-        int actor_i, actor_j;
-        for (int i = 0; i < size; i++) { 
-            actor_i = name_to_int[actors[i]];
-            for (int j = i + 1; j < size; j++) { 
-                actor_j = name_to_int[actors[j]];
-                graph[actor_i][actor_j] = 1;
-                graph[actor_j][actor_i] = 1;
-            }
-        }
-    }
-    cout << "Finished creating graph..." << endl; 
-
-    // Init counts vector 
-    counts = vector<int>(int_to_name.size(), 0);
-
-    for (int i = 0; i < (int)graph.size(); i++) { 
-        for (int j = 0; j < (int)graph.size(); j++) { 
-            counts[i] += graph[i][j];
-        }
-    }
-    cout << "Finished first pass counts..." << endl; 
-}
-
-
-
+/*
+ * This file fully contains the methods necessary to run the popularityfinder
+ * program, which finds actors of a certain popularity through k-core graph
+ * decomposition, or (alpha, beta)-core decomposition of actors and movies.
+ */
+
+#include <algorithm>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+#include "actorgraph.hpp"
+#include "bicore.hpp"
+#include "graphmatrix.hpp"
+#include "neighborsets.hpp"
+#include "options.hpp"
+#include "sparsematrix.hpp"
+
+using namespace std;
+
+// Usage string
+const static string USAGE = 
+    "./popularityfinder called with "
+    "incorrect arguments.\nUsage: ./popularityfinder "
+    "data.tsv k pop_actors\n"
+    "       ./popularityfinder data.tsv alpha beta pop_actors\n";
+
+// Function declarations for main
+static bool BuildStructures(const char*);
+static int RunBiCore(const char*, int, int, const char*);
+
+// Actors and movies read from the tsv file, with actor ids in name order
+static ActorGraph actor_graph;
+
+// Sparse adjacency matrix for graph that holds actor connections. [i][j] 
+// stored = connection from actor i to actor j. 
+static CsrMatrix<char> graph; 
+
+// Co-stars of every actor, the rows of graph (see neighborsets.hpp)
+static NeighborSets costars;
+
+// Holds count of each actor
+static vector<int> counts;
+
+/*
+ * Runs the popularityfinder program, performing k-core graph decomposition
+ * based on passed k. Edges between actors based on mutual movies. 
+ *
+ * Parameters: 
+ *  argv[1] - data.tsv
+ *      Tab delimited file of movie actor relationships. Header row expected.
+ *      Rows should be formatted as actor name, movie title, and movie year.
+ *  argv[2] - k
+ *      The minimum number of connections between actors to remain in the output
+ *      file. The target used for k-core decomposition.
+ *  argv[3] - pop_actors 
+ *      The output file name of actors popular enough, with at least k 
+ *      connections. 
+ *
+ * Given alpha and beta in place of k, the (alpha, beta)-core is written
+ * instead, see RunBiCore.
+ */
+int main(int argc, char *argv[]) {
+    // Check number of cmdline args, and that k, alpha and beta are
+    // non-negative integers
+    int k, beta = 0;
+    if ((argc != 4 && argc != 5) || !parseInt(argv[2], k) || k < 0 ||
+        (argc == 5 && (!parseInt(argv[3], beta) || beta < 0))) {
+        cout << USAGE; 
+        return -1;
+    }
+    if (argc == 5)
+        return RunBiCore(argv[1], k, beta, argv[4]);
+
+    // Open files
+    ifstream tsv_file(argv[1]);
+    ofstream out_file(argv[3]);
+
+    // Check proper file opening
+    if (!tsv_file || !out_file) { 
+        cout << "Error opening file!" << endl;
+        return -1;
+    }
+
+    // Create structures
+    if (!BuildStructures(argv[1])) { 
+        cout << "Error opening file!" << endl;
+        return -1;
+    }
+
+    // Flags actors which have not been pruned
+    vector<int> alive(counts.size(), 1);
+    vector<int> removed;
+
+    bool not_done = true;
+    // Perform k-core pruning
+    while (not_done) {
+        cout << "Pruning...\n";
+        removed.clear();
+        // Remove vertices lower than count
+        for (int i = 0; i < (int)counts.size(); i++) {
+            if (alive[i] && counts[i] < k) {
+                alive[i] = 0;
+                removed.push_back(i);
+            }
+        }
+        not_done = !removed.empty();
+        // Take the removed actors from the live neighbor counts of their
+        // co-stars, touching only the sets of the removed
+        for (int i : removed)
+            costars.forEach(i, [&](int j) { counts[j]--; });
+    }
+
+
+    // Keep actors with greater than k connections
+    vector<string> names;
+    for (int i = 0; i < (int)counts.size(); i++) { 
+        if (alive[i])
+            names.push_back(actor_graph.actorName(i));
+    }
+
+    // Sort the actors alphabetically by name 
+    sort(names.begin(), names.end());
+
+    out_file << "Actor\n";
+    for (string s : names) { 
+        out_file << s << '\n';
+    }
+
+    tsv_file.close();
+    out_file.close();
+
+    return 0;
+}
+
+
+/*
+ * Builds sparse adjacency matrix, co-star sets and first pass counts.
+ * Modifies actor_graph, graph, costars, and counts. 
+ * 
+ * Params
+ *  tsv_name - 
+ *      Input file of actors and their movies. Assumes tsv file is 3 columns,
+ *      with a header. First column contains actor name, second movie, third
+ *      movie year. 
+ *      Used to build actor_graph and graph
+ *
+ * Return: 
+ *  bool - 
+ *      True indicates successful reading of the tsv file. 
+ */ 
+static bool BuildStructures(const char* tsv_name) { 
+
+    // Read in the tsv file
+    if (!actor_graph.loadFromFile(tsv_name, false)) { 
+        return false;
+    }
+    cout << "Finished reading tsv..." << endl; 
+
+    // Connect all actors of each movie to one another: B * B^T over (or, and)
+    graph = coStarMatrix(actor_graph);
+    cout << "Finished creating graph..." << endl; 
+
+    // Count neighbors of every actor, the size of its set
+    costars.build(graph);
+    counts.resize(costars.numSets());
+    for (int i = 0; i < costars.numSets(); i++)
+        counts[i] = costars.size(i);
+    cout << "Finished first pass counts..." << endl; 
+    return true;
+}
+
+
+/*
+ * Writes the actors of the (alpha, beta)-core: actors cast in at least alpha
+ * movies, each casting at least beta actors of the core. Peeled from the
+ * roles directly (see bicore.hpp), without building the co-star matrix.
+ *
+ * Parameters:
+ *  tsv_name -
+ *      Input file of actors and their movies, as for BuildStructures.
+ *  alpha -
+ *      Movies of the core each actor must be cast in.
+ *  beta -
+ *      Actors of the core each movie must cast.
+ *  out_name -
+ *      The output file name of the actors of the core.
+ *
+ * Return:
+ *  int -
+ *      Exit status. -1 for unsuccessful reading or opening, 0 otherwise.
+ */
+static int RunBiCore(const char* tsv_name, int alpha, int beta,
+                     const char* out_name) {
+    ofstream out_file(out_name);
+    if (!out_file || !actor_graph.loadFromFile(tsv_name, false)) {
+        cout << "Error opening file!" << endl;
+        return -1;
+    }
+    cout << "Finished reading tsv..." << endl;
+
+    BiCore core = peelBiCore(actor_graph, alpha, beta);
+    cout << "Kept " << core.actors.size() << " actors and "
+         << core.movies.size() << " movies..." << endl;
+
+    // Actor ids are in name order
+    out_file << "Actor\n";
+    for (int a : core.actors)
+        out_file << actor_graph.actorName(a) << '\n';
+    return 0;
+}
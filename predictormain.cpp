@@ -1,262 +1,553 @@
-/*  
- * File contains static methods to fully run the predictorandrecommender 
- * program, predicting future interactions and new collaborations of actors. 
- * Details of usage beneath. 
- */
-
-#include <algorithm>
-#include <string>
-#include <sstream>
-#include <iostream>
-#include <fstream>
-#include <unordered_map>
-#include <vector>
-
-using namespace std;
-
-const static string USAGE = 
-    "./predictorandrecommender called with "
-    "incorrect arguments.\nUsage: ./predictorandrecommender "
-    "data.tsv predict_recommend_targets predicted_interact"
-    " recommended_collab\n";
-
-// Function declarations for main
-static void BuildStructures(ifstream&, ifstream&);
-static void FindInteractions(bool, ofstream&);
-static bool compare(const pair<int, string>&, const pair<int, string>&);
-
-// Bidirectional map for string <-> int conversions for matrix 
-static unordered_map<string, int> name_to_int; 
-static vector<string> int_to_name;
-
-// Names of actors to find 
-static vector<string> actors; 
-
-// Adjacency matrix for graph that holds actor connections. [i][j] = connection
-// from actor i to actor j. 
-static vector<vector<int>> graph; 
-
-
-/*
- * Parses command line arguments and calls file methods for the 
- * predictorandrecommender program.
- * 
- * Parameters: 
- *  argv[1] - data.tsv
- *      Tab delimited file of movie actor relationships. Header row expected.
- *      Rows should be formatted as actor name, movie title, and movie year.
- *  argv[2] - targets
- *      File of actor names to suggest for. Header row expected. 
- *  argv[3] - future_interactions.tsv 
- *      Output file of future interactions.
- *  argv[4] - new_collaborations.tsv 
- *      Output file of new collaborations.
- * Return: 
- *  int - 
- *      Exit status. -1 for unsuccessful reading or parsing, 0 otherwise. 
- */ 
-int main(int argc, char *argv[]) {
-    // Check number of arguments
-    if (argc != 5) { 
-        cout << USAGE; 
-        return -1;
-    }
-    // Open files and check for successful opening
-    ifstream tsv_file(argv[1]);
-    ifstream actors_file(argv[2]); 
-    ofstream interact_file(argv[3]); 
-    ofstream collab_file(argv[4]); 
-    if (!tsv_file || !actors_file || !interact_file || !collab_file) { 
-        cout << "Failed to read or open files!\n"; 
-        return -1; 
-    }
-
-
-    // Builds graph, actors, name_to_int, and int_to_name
-    BuildStructures(tsv_file, actors_file);
-    // Write top 4 future interactions to interact_file for each actor in actors
-    cout << "Finding top predicted interactions ..." << endl;
-    FindInteractions(true, interact_file); 
-    // Write top 4 new collaborations to collab_file for each actor in actors
-    cout << "Finding top recommended collaborations ..." << endl;
-    FindInteractions(false, collab_file); 
-
-
-    // Close all files
-    tsv_file.close();
-    actors_file.close();
-    interact_file.close();
-    collab_file.close();
-
-    return 0;
-}
-
-
-/*
- * Builds adjacency matrix, bidirectional map for matrix access, and vector of
- * actors to find predictions for.
- * Modifies graph, actors, name_to_int, and int_to_name. 
- * 
- * Parameters:
- *  tsv - 
- *      Input file of actors and their movies. Assumes tsv file is 3 columns,
- *      with a header. First column contains actor name, second movie, third
- *      movie year. 
- *      Used to build graph, name_to_int, int_to_name
- *  actors_file - 
- *      Input file of actors to find connections for. First row contains
- *      header. Each new row is an actor name. 
- *      Used to build actors.
- */
-static void BuildStructures(ifstream& tsv_file, ifstream& actors_file) { 
-
-    // Holds the next line when reading in the file
-    string line;
-
-    // Discard the header
-    getline(tsv_file, line); 
-
-    // Temporary data structure to build adjacency matrix, maps movies to actors
-    unordered_map<string, vector<string>> movie_to_actor;
-
-    // Read in the tsv file, ending when EOF reached
-    while (getline(tsv_file, line)) {
-        // Tokenize the line into strings 
-        istringstream ss(line);
-        vector<string> record;
-        // Parse the line by tabs, storing each word in record 
-        string next; 
-        while (getline(ss, next, '\t')) {
-                record.push_back(next);
-        }
-
-        string actor_name(record[0]);
-        string movie_title(record[1].append(record[2]));
-
-        // Build name_to_int, int_to_name
-        if (!name_to_int.count(actor_name)) { 
-            name_to_int[actor_name] = int_to_name.size();
-            int_to_name.push_back(actor_name);
-        }
-
-        // Build temporary data structure which maps movies to actors
-        if (!movie_to_actor.count(movie_title)) { 
-            movie_to_actor[movie_title] = vector<string>();
-        }
-        movie_to_actor[movie_title].push_back(actor_name);
-
-    }
-    cout << "Finished reading tsv ..." << endl; 
-
-    // Create adjacency matrix of correct size
-    graph = vector<vector<int>>(int_to_name.size(), 
-        vector<int>(int_to_name.size(), 0));
-
-    // Create adjacency matrix from movie_to_actor 
-    for (auto pair : movie_to_actor) { 
-        vector<string>& actors = pair.second; 
-        int size = (int) actors.size();
-        // Connect all actors for a movie to one another in graph
-        for (int i = 0; i < size; i++) { 
-            for (int j = i + 1; j < size; j++) { 
-                graph[name_to_int[actors[i]]][name_to_int[actors[j]]] = 1;
-                graph[name_to_int[actors[j]]][name_to_int[actors[i]]] = 1;
-            }
-        }
-    }
-    cout << "Finished creating graph ..." << endl; 
-
-    // Skip header
-    getline(actors_file, line);
-    // Read in actors to find connections for 
-    while (getline(actors_file, line)) { 
-        actors.push_back(line); 
-    }
-}
-
-
-/*
- * Writes top interactions of actors to output file, based on parameters. 
- * Requires built graph, actors, name_to_int, and int_to_name.
- *
- * Parameters:
- *  neighbor - 
- *      Whether to look for top interactions with neighbors xor not
- *      neighbors. true signifies searching for future interactions, while false
- *      signifies searching for potential new collaborations. 
- *      Future interactions -> neighbors, highest num common neighbors
- *      New collaborations -> not neighbor, highest num common neighbors
- *  out_file - 
- *      Output file of where to write predicted interactions to.
- */
-static void FindInteractions(bool neighbor, ofstream& out_file) { 
-
-    // Maximum number of interactions to report
-    int predict_max = 4;
-
-    // Stores actors & frequency counts for each possible interact / collab  
-    vector<pair<int, string>> predicts; 
-
-    // Write header to file 
-    out_file << "Actor1,Actor2,Actor3,Actor4\n";
-
-    // Find suggestions for each actor
-    for (string actor : actors) { 
-        cout << "Computing for (" << actor << ")" << endl; 
-        vector<int>& row = graph[name_to_int[actor]]; 
-        int row_size = (int)row.size(); 
-
-        // Stores mutual neighbors for each other actor by col number
-        vector<int> mutual_count(row_size, 0);
-
-        // Calculates dot product of each row with other row for mutual count
-        for (int dot_ind = 0; dot_ind < row_size; dot_ind++) { 
-            for (int i = 0; i < row_size; i++) {
-                mutual_count[dot_ind] += (graph[dot_ind][i] & row[i]);
-            }
-        }
-        // Zero out it's own row entry 
-        mutual_count[name_to_int[actor]] = 0;
-
-        // Save possible predictions for actor
-        for (int i = 0; i < row_size; i++) { 
-
-            // Only check neighbors or not neighbors, depending on param
-            if (row[i] == neighbor) { 
-                // Retrieve frequency of mutual connections with vertex, name
-                predicts.push_back(
-                    pair<int, string>(
-                    mutual_count[i], int_to_name[i]));
-            }
-        }
-        // Sort predictions by freq, then string value using compare 
-        sort(predicts.begin(), predicts.end(), compare);
-
-        // Output predictions to file
-        for (int i = 0; i < (int)predicts.size(); i++) { 
-            // Zero for value of neighbor, greater than max num predictions
-            if (!predicts[i].first || i >= predict_max) { 
-                break;
-            }
-            out_file << predicts[i].second << (i != predict_max-1 ? "\t" : "");
-        }
-        out_file << "\n"; 
-
-        predicts.clear();
-    }
-}
-
-
-/* 
- * Helper function to compare pair<int, string>. When used as operator<, sorts
- * in decreasing order (largest first) for int, and increasing order (smallest
- * first) for string.
- */
-static bool compare(const pair<int, string>& x, const pair<int, string>& y) { 
-    // Compare strings in order of increasing order (smallest first)
-    if (x.first == y.first) { 
-        return x.second < y.second; 
-    }
-    // Compare int in decreasing order (largest first) 
-    return x.first > y.first; 
-}
+/*  
+ * File contains static methods to fully run the predictorandrecommender 
+ * program, predicting future interactions and new collaborations of actors. 
+ * Details of usage beneath. 
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+#include "actorgraph.hpp"
+#include "checkpoint.hpp"
+#include "graphmatrix.hpp"
+#include "memory.hpp"
+#include "options.hpp"
+#include "parallel.hpp"
+#include "sparsematrix.hpp"
+#include "trace.hpp"
+#include "tuning.hpp"
+
+using namespace std;
+
+const static string USAGE = 
+    "./predictorandrecommender called with "
+    "incorrect arguments.\nUsage: ./predictorandrecommender "
+    "data.tsv predict_recommend_targets predicted_interact"
+    " recommended_collab [--threads=N] [--active-from=YEAR]"
+    " [--active-to=YEAR] [--exclude=actors_file] [--checkpoint=N]"
+    " [--resume] [--holdout=YEAR] [--holdout-sample=N] [--memory]\n";
+
+// Function declarations for main
+static bool BuildStructures(const char*, ifstream&);
+static bool BuildFilters(const Options&);
+static bool FindInteractions(bool, const string&, Checkpoint&);
+static vector<vector<int>> TopByProduct(bool, const vector<int>&, int);
+static void EvaluateHoldout(bool, const ActorGraph&, const vector<int>&);
+
+// Actors and movies read from the tsv file, with actor ids in name order
+static ActorGraph actor_graph;
+
+// Names of actors to find 
+static vector<string> actors; 
+
+// Maximum number of suggestions per target
+const static int PREDICT_MAX = 4;
+
+// Sparse adjacency matrix for graph that holds actor connections. [i][j] 
+// stored = connection from actor i to actor j. 
+static CsrMatrix<char> graph; 
+
+// Flags actors which may be suggested, passing the activity window and not 
+// excluded. Applied inside the kernels, so filtered actors are never counted.
+static vector<char> allowed;
+
+// Number of targets between checkpoints, 0 for none, and whether to resume
+// from the checkpoints of an earlier run
+static int checkpoint_every = 0;
+static bool resume_batch = false;
+
+// First year held out of the graph to score suggestions against, 0 for none
+static int holdout_year = 0;
+
+
+/*
+ * Parses command line arguments and calls file methods for the 
+ * predictorandrecommender program.
+ * 
+ * Parameters: 
+ *  argv[1] - data.tsv
+ *      Tab delimited file of movie actor relationships. Header row expected.
+ *      Rows should be formatted as actor name, movie title, and movie year.
+ *  argv[2] - targets
+ *      File of actor names to suggest for. Header row expected. 
+ *  argv[3] - future_interactions.tsv 
+ *      Output file of future interactions.
+ *  argv[4] - new_collaborations.tsv 
+ *      Output file of new collaborations.
+ *  --threads=N
+ *      Optional number of threads to use, by default those tuned for
+ *      data.tsv by the analyzer's autotune mode. 
+ *  --active-from=YEAR, --active-to=YEAR
+ *      Only suggest actors with a movie in or spanning the given years: 
+ *      their last movie is no earlier than active-from, and their first 
+ *      movie no later than active-to. 
+ *  --exclude=actors_file
+ *      Never suggest the actors listed in actors_file, one per line after a
+ *      header row. 
+ *  --checkpoint=N
+ *      Flush each output and record progress every N targets, in the output
+ *      name plus .ckpt.
+ *  --resume
+ *      Continue from the checkpoints of an earlier run if present, keeping
+ *      the suggestions already written.
+ *  --holdout=YEAR
+ *      Suggest from the movies before YEAR only, then score the suggestions
+ *      against the co-starring of YEAR and after: precision and recall of 
+ *      the top 1 to 4, per target latency and throughput.
+ *  --holdout-sample=N
+ *      Score N actors spread evenly over the graph rather than the targets.
+ *  --memory
+ *      Report the bytes held by each structure once built.
+ * Return: 
+ *  int - 
+ *      Exit status. -1 for unsuccessful reading or parsing, 0 otherwise. 
+ */ 
+int main(int argc, char *argv[]) {
+    TRACE_FILE(string(argv[0]) + ".trace.json");
+    TRACE_THREAD("main");
+    // Check number of arguments
+    Options options;
+    if (!options.parse(argc, argv, {"threads", "active-from", "active-to", 
+                                      "exclude", "checkpoint", "resume",
+                                      "holdout", "holdout-sample", "memory"},
+                       {"threads", "active-from", "active-to", "checkpoint",
+                        "holdout", "holdout-sample"}) || 
+        options.args().size() != 4) { 
+        cout << USAGE; 
+        return -1;
+    }
+    const vector<string>& args = options.args();
+    Tuning tuning(args[0]);
+    tuning.load();
+    setNumThreads(options.getInt("threads", tuning.getInt("threads", 0)));
+    checkpoint_every = options.getInt("checkpoint", 0);
+    resume_batch = options.has("resume");
+    holdout_year = options.getInt("holdout", 0);
+
+    // Open targets file and check for successful opening
+    ifstream actors_file(args[1]); 
+    if (!actors_file) { 
+        cout << "Failed to read or open files!\n"; 
+        return -1; 
+    }
+
+
+    // Builds actor_graph, graph, and actors
+    if (!BuildStructures(args[0].c_str(), actors_file) || 
+        !BuildFilters(options)) { 
+        cout << "Failed to read or open files!\n"; 
+        return -1; 
+    }
+    if (options.has("memory")) { 
+        MemoryReport memory;
+        actor_graph.memoryUsage(memory);
+        memory.add("co-star matrix", graph.bytes());
+        memory.add("target names", memoryBytes(actors));
+        memory.add("suggestable actors", memoryBytes(allowed));
+        memory.write(cout);
+    }
+    // Write top 4 future interactions to interact_file for each actor in actors
+    cout << "Finding top predicted interactions ..." << endl;
+    string settings = "holdout=" + options.get("holdout") + 
+                      " active-from=" + options.get("active-from") + 
+                      " active-to=" + options.get("active-to") + 
+                      " exclude=" + options.get("exclude");
+    Checkpoint interact_checkpoint(args[2], args[1], args[0], settings);
+    if (!FindInteractions(true, args[2], interact_checkpoint)) { 
+        cout << "Failed to read or open files!\n"; 
+        return -1; 
+    }
+    // Write top 4 new collaborations to collab_file for each actor in actors
+    cout << "Finding top recommended collaborations ..." << endl;
+    Checkpoint collab_checkpoint(args[3], args[1], args[0], settings);
+    if (!FindInteractions(false, args[3], collab_checkpoint)) { 
+        cout << "Failed to read or open files!\n"; 
+        return -1; 
+    }
+
+    // Close all files, the batch being finished
+    actors_file.close();
+    interact_checkpoint.remove();
+    collab_checkpoint.remove();
+
+    // Score the suggestions against the held out years
+    if (holdout_year) { 
+        ActorGraph future;
+        if (!future.loadFromFile(args[0].c_str(), false, holdout_year)) { 
+            cout << "Failed to read or open files!\n"; 
+            return -1; 
+        }
+        vector<int> scored_ids;
+        int sample = options.getInt("holdout-sample", 0);
+        if (sample > 0) { 
+            int n = actor_graph.numActors();
+            sample = min(sample, n);
+            for (int i = 0; i < sample; i++) 
+                scored_ids.push_back((int)((long long)i * n / sample));
+        } else { 
+            for (const string& actor : actors) { 
+                if (actor_graph.actorId(actor) >= 0) 
+                    scored_ids.push_back(actor_graph.actorId(actor));
+            }
+        }
+        cout << "Scoring " << scored_ids.size() << " actors against " 
+             << future.numMovies() << " movies from " << holdout_year 
+             << " ..." << endl;
+        EvaluateHoldout(true, future, scored_ids);
+        EvaluateHoldout(false, future, scored_ids);
+    }
+
+    return 0;
+}
+
+
+/*
+ * Builds sparse adjacency matrix and vector of actors to find predictions for.
+ * Modifies actor_graph, graph, and actors. 
+ * 
+ * Parameters:
+ *  tsv_name - 
+ *      Input file of actors and their movies. Assumes tsv file is 3 columns,
+ *      with a header. First column contains actor name, second movie, third
+ *      movie year. 
+ *      Used to build actor_graph and graph
+ *  actors_file - 
+ *      Input file of actors to find connections for. First row contains
+ *      header. Each new row is an actor name. 
+ *      Used to build actors.
+ *
+ * Return: 
+ *  bool - 
+ *      True indicates successful reading of the tsv file. 
+ */
+static bool BuildStructures(const char* tsv_name, ifstream& actors_file) { 
+    TRACE_SCOPE("build structures");
+
+    // Holds the next line when reading in the file
+    string line;
+
+    // Read in the tsv file, up to the held out years if any
+    if (!actor_graph.loadFromFile(tsv_name, false, INT_MIN, 
+                                  holdout_year ? holdout_year - 1 : INT_MAX)) { 
+        return false;
+    }
+    cout << "Finished reading tsv ..." << endl; 
+
+    // Connect all actors of each movie to one another: B * B^T over (or, and)
+    graph = coStarMatrix(actor_graph);
+    cout << "Finished creating graph ..." << endl; 
+
+    // Skip header
+    getline(actors_file, line);
+    // Read in actors to find connections for 
+    while (getline(actors_file, line)) { 
+        actors.push_back(line); 
+    }
+    return true;
+}
+
+
+/*
+ * Builds the flags of actors which may be suggested from the activity window
+ * and exclusion options. Modifies allowed. Requires built actor_graph.
+ *
+ * Parameters:
+ *  options - 
+ *      Command line options, see main.
+ *
+ * Return: 
+ *  bool - 
+ *      True indicates successful reading of the exclusion file, if any. 
+ */
+static bool BuildFilters(const Options& options) { 
+    int active_from = options.getInt("active-from", INT_MIN);
+    int active_to = options.getInt("active-to", INT_MAX);
+
+    allowed.assign(actor_graph.numActors(), 1);
+    for (int i = 0; i < actor_graph.numActors(); i++) { 
+        if (actor_graph.actorLastYear(i) < active_from || 
+            actor_graph.actorFirstYear(i) > active_to) 
+            allowed[i] = 0;
+    }
+
+    if (options.has("exclude")) { 
+        ifstream exclude_file(options.get("exclude"));
+        if (!exclude_file) 
+            return false;
+        string line;
+        getline(exclude_file, line);
+        while (getline(exclude_file, line)) { 
+            if (actor_graph.actorId(line) >= 0) 
+                allowed[actor_graph.actorId(line)] = 0;
+        }
+    }
+
+    int count = 0;
+    for (char a : allowed) 
+        count += a;
+    cout << count << " of " << allowed.size() 
+         << " actors may be suggested ..." << endl;
+    return true;
+}
+
+
+/*
+ * Writes top interactions of actors to output file, based on parameters. 
+ * Targets are processed a chunk at a time when checkpointing, recording
+ * progress after each. Requires built graph and actors.
+ *
+ * Parameters:
+ *  neighbor - 
+ *      Whether to look for top interactions with neighbors xor not
+ *      neighbors. true signifies searching for future interactions, while false
+ *      signifies searching for potential new collaborations. 
+ *      Future interactions -> neighbors, highest num common neighbors
+ *      New collaborations -> not neighbor, highest num common neighbors
+ *  out_name - 
+ *      Output file of where to write predicted interactions to.
+ *  checkpoint - 
+ *      Checkpoint of the output, resumed from if resume_batch is set.
+ *
+ * Return: 
+ *  bool - 
+ *      True indicates the output was opened and written. 
+ */
+static bool FindInteractions(bool neighbor, const string& out_name, 
+                             Checkpoint& checkpoint) { 
+    TRACE_SCOPE(neighbor ? "interactions" : "collaborations");
+
+    // Maximum number of interactions to report
+    int predict_max = PREDICT_MAX;
+
+    // Open output, continuing after the targets done by an earlier run
+    if (resume_batch && checkpoint.load()) { 
+        cout << "Resuming after " << checkpoint.done << " of " 
+             << actors.size() << " actors ..." << endl;
+    } else if (checkpoint.mismatch) { 
+        cout << "Checkpoint of " << out_name << " records another graph, "
+             << "targets file or filters, not resuming." << endl;
+        return false;
+    }
+    ofstream out_file;
+    if (!checkpoint.open(out_file, out_name)) 
+        return false;
+
+    // Write header to file 
+    if (checkpoint.done == 0) 
+        out_file << "Actor1,Actor2,Actor3,Actor4\n";
+
+    size_t chunk = checkpoint_every > 0 ? checkpoint_every : actors.size();
+    for (size_t lo = checkpoint.done, hi; lo < actors.size(); lo = hi) { 
+        hi = min(actors.size(), lo + max(chunk, (size_t)1));
+
+        // Ids of the targets of the chunk known to the graph
+        vector<int> target_ids;
+        for (size_t i = lo; i < hi; i++) { 
+            if (actor_graph.actorId(actors[i]) >= 0) 
+                target_ids.push_back(actor_graph.actorId(actors[i]));
+        }
+
+        // Top suggestions of each target, best first
+        vector<vector<int>> suggestions = TopByProduct(neighbor, target_ids,
+                                                       PREDICT_MAX);
+
+        // Write suggestions for each actor
+        int row = 0;
+        for (size_t t = lo; t < hi; t++) { 
+            const string& actor = actors[t];
+            cout << "Computing for (" << actor << ")" << endl; 
+            if (actor_graph.actorId(actor) < 0) { 
+                out_file << "\n";
+                continue;
+            }
+
+            // Output predictions to file
+            vector<int>& found = suggestions[row++];
+            for (int i = 0; i < (int)found.size(); i++) { 
+                out_file << actor_graph.actorName(found[i]) 
+                    << (i != predict_max-1 ? "\t" : "");
+            }
+            out_file << "\n"; 
+        }
+
+        if (checkpoint_every > 0) 
+            checkpoint.save(out_file, hi);
+    }
+    out_file.close();
+    return (bool)out_file;
+}
+
+
+/*
+ * Finds the top suggestions of every target by computing all mutual neighbor 
+ * counts. The counts of every target are the rows of the product A_t * A over
+ * (plus, pair), where A_t holds the targets' rows of the adjacency matrix A.
+ * The product is masked to the targets' neighbors, or to their non-neighbors
+ * other than themselves, and to allowed actors, so only candidates are 
+ * counted.
+ *
+ * Parameters:
+ *  neighbor - 
+ *      Whether candidates are the targets' neighbors xor not neighbors.
+ *  target_ids - 
+ *      Actors to find suggestions for.
+ *  predict_max - 
+ *      Maximum number of suggestions per target.
+ *
+ * Return: 
+ *  vector - 
+ *      Suggestions of each target, highest count then lowest id first.
+ */
+static vector<vector<int>> TopByProduct(bool neighbor, 
+                                        const vector<int>& target_ids, 
+                                        int predict_max) { 
+    CsrMatrix<char> target_rows = selectRows(graph, target_ids);
+    CsrMatrix<char> mask = target_rows;
+    if (!neighbor) { 
+        // Non-neighbors exclude the target itself
+        mask = CsrMatrix<char>();
+        mask.rows = target_rows.rows;
+        mask.cols = target_rows.cols;
+        for (int t = 0; t < (int)target_ids.size(); t++) { 
+            const int* cols = target_rows.rowIndices(t);
+            int size = target_rows.rowSize(t);
+            int pos = (int)(lower_bound(cols, cols + size, target_ids[t]) 
+                - cols);
+            mask.indices.insert(mask.indices.end(), cols, cols + pos);
+            mask.indices.push_back(target_ids[t]);
+            mask.indices.insert(mask.indices.end(), cols + pos, cols + size);
+            mask.offsets.push_back((int)mask.indices.size());
+        }
+        mask.values.assign(mask.indices.size(), 1);
+    }
+    CsrMatrix<int> mutual_count = maskedSpgemm<PlusPair<int>>(
+        target_rows, graph, mask, !neighbor, allowed);
+
+    vector<vector<int>> suggestions(target_ids.size());
+    for (int row = 0; row < mutual_count.rows; row++) { 
+        // Order candidates by highest count, then lowest id
+        vector<pair<int, int>> predicts; 
+        const int* cols = mutual_count.rowIndices(row);
+        const int* counts = mutual_count.rowValues(row);
+        for (int i = 0; i < mutual_count.rowSize(row); i++) { 
+            predicts.push_back(pair<int, int>(-counts[i], cols[i]));
+        }
+        int found = min(predict_max, (int)predicts.size());
+        partial_sort(predicts.begin(), predicts.begin() + found, 
+            predicts.end());
+        for (int i = 0; i < found; i++) 
+            suggestions[row].push_back(predicts[i].second);
+    }
+    return suggestions;
+}
+
+
+/*
+ * Scores the suggestions of actors against the co-starring of the held out 
+ * years, and times finding them. A suggestion is a hit if the pair co-stars
+ * in a held out movie. Future interactions can only hit the actor's existing
+ * co-stars, and new collaborations only the others which may be suggested, 
+ * so the co-stars each could find are its relevant set; actors without any 
+ * are not scored. Precision at k is the hits among the top k over k, and 
+ * recall at k the hits over the relevant set, each averaged over the scored
+ * actors. 
+ *
+ * Throughput is timed over all of the actors in one batch, as the output is 
+ * found, and latency over each actor alone. Requires built graph and 
+ * allowed.
+ *
+ * Parameters:
+ *  neighbor - 
+ *      Whether to score future interactions xor new collaborations.
+ *  future - 
+ *      Graph of the held out years.
+ *  target_ids - 
+ *      Actors to score.
+ */
+static void EvaluateHoldout(bool neighbor, const ActorGraph& future, 
+                            const vector<int>& target_ids) { 
+    typedef chrono::steady_clock Clock;
+
+    // Suggestions of all actors at once
+    auto begin = Clock::now();
+    vector<vector<int>> suggestions = TopByProduct(neighbor, target_ids,
+                                                   PREDICT_MAX);
+    chrono::duration<double> batch_time = Clock::now() - begin;
+
+    // Latency of each actor alone
+    vector<double> latency;
+    for (int id : target_ids) { 
+        begin = Clock::now();
+        TopByProduct(neighbor, vector<int>(1, id), PREDICT_MAX);
+        chrono::duration<double> elapsed = Clock::now() - begin;
+        latency.push_back(elapsed.count() * 1000);
+    }
+    sort(latency.begin(), latency.end());
+
+    vector<double> precision(PREDICT_MAX, 0);
+    vector<double> recall(PREDICT_MAX, 0);
+    int scored = 0;
+    for (int row = 0; row < (int)target_ids.size(); row++) { 
+        int target = target_ids[row];
+        const int* nbrs = graph.rowIndices(target);
+        int degree = graph.rowSize(target);
+
+        // Co-stars of the held out years the actor could be suggested
+        vector<int> relevant;
+        int future_id = future.actorId(actor_graph.actorName(target));
+        if (future_id >= 0) { 
+            for (int m : future.moviesOf(future_id)) { 
+                for (int c : future.castOf(m)) { 
+                    int id = actor_graph.actorId(future.actorName(c));
+                    if (id < 0 || id == target) 
+                        continue;
+                    bool known = binary_search(nbrs, nbrs + degree, id);
+                    if (neighbor ? known : (!known && allowed[id])) 
+                        relevant.push_back(id);
+                }
+            }
+        }
+        sort(relevant.begin(), relevant.end());
+        relevant.erase(unique(relevant.begin(), relevant.end()), 
+                       relevant.end());
+        if (relevant.empty()) 
+            continue;
+
+        scored++;
+        int hits = 0;
+        const vector<int>& found = suggestions[row];
+        for (int k = 0; k < PREDICT_MAX; k++) { 
+            if (k < (int)found.size() && 
+                binary_search(relevant.begin(), relevant.end(), found[k])) 
+                hits++;
+            precision[k] += (double)hits / (k + 1);
+            recall[k] += (double)hits / relevant.size();
+        }
+    }
+
+    cout << (neighbor ? "Future interactions" : "New collaborations") 
+         << ": scored " << scored << " of " << target_ids.size() 
+         << " actors with co-stars after the holdout" << endl;
+    for (int k = 0; k < PREDICT_MAX; k++) { 
+        cout << "  precision@" << k + 1 << " " 
+             << precision[k] / max(scored, 1) << ", recall@" << k + 1 << " "
+             << recall[k] / max(scored, 1) << endl;
+    }
+    if (!latency.empty()) { 
+        double total = 0;
+        for (double ms : latency) 
+            total += ms;
+        size_t n = latency.size();
+        cout << "  latency " << total / n << "ms mean, " << latency[n / 2] 
+             << "ms p50, " << latency[min(n - 1, n * 95 / 100)] 
+             << "ms p95, " << latency.back() << "ms max; throughput " 
+             << n / max(batch_time.count(), 1e-9) << " actors/s batched" 
+             << endl;
+    }
+}
@@ -0,0 +1,238 @@
+/*
+ * This file contains a vertex centric, bulk synchronous execution engine in
+ * the style of Pregel. An analysis supplies a compute function run for every
+ * active vertex of a graph once per superstep. Compute reads the vertex's
+ * value and the combined messages sent to it in the previous superstep, may
+ * update the value, send messages along edges, contribute to the aggregator
+ * and vote to halt. A halted vertex is woken again by any message. The run
+ * ends when every vertex has halted and no messages are in flight.
+ *
+ * Vertices are split into contiguous partitions run in parallel. Senders
+ * append messages to per partition outboxes, then each partition combines
+ * the outboxes addressed to it, so no two threads write the same vertex and
+ * no locks are taken.
+ *
+ * Example, labelling connected components with the smallest vertex id:
+ *
+ *  struct MinCombiner {
+ *      int operator()(int x, int y) const { return min(x, y); }
+ *  };
+ *  PregelEngine<char, int, int, MinCombiner> engine(graph, 0);
+ *  engine.run([](PregelEngine<char, int, int, MinCombiner>::Context& c) {
+ *      int label = c.superstep() == 0 ? c.vertex() : c.value();
+ *      if (c.hasMessage()) label = min(label, c.message());
+ *      if (c.superstep() == 0 || label < c.value()) {
+ *          c.value() = label;
+ *          c.sendToNeighbors(label);
+ *      }
+ *      c.voteToHalt();
+ *  });
+ */
+
+#ifndef PREGEL_HPP
+#define PREGEL_HPP
+
+#include <algorithm>
+#include <vector>
+#include "parallel.hpp"
+#include "sparsematrix.hpp"
+
+using namespace std;
+
+// Aggregator which ignores all contributions, for analyses needing none.
+struct NoAggregate {
+    char operator()(char, char) const { return 0; }
+};
+
+/*
+ * Bulk synchronous engine over the rows of a CSR matrix. Row i lists the out
+ * edges of vertex i; edge values are available to compute.
+ *
+ * Template parameters:
+ *  E          - edge value type of the graph.
+ *  Value      - per vertex value.
+ *  Message    - message type.
+ *  Combiner   - associative, commutative Message (Message, Message) functor
+ *               merging two messages addressed to one vertex.
+ *  Aggregate  - global aggregate value type.
+ *  Aggregator - associative, commutative Aggregate (Aggregate, Aggregate).
+ */
+template <class E, class Value, class Message, class Combiner,
+          class Aggregate = char, class Aggregator = NoAggregate>
+class PregelEngine {
+public:
+    // Interface of compute to the engine for one vertex in one superstep.
+    class Context {
+    private:
+        friend class PregelEngine;
+        PregelEngine* engine;
+        int partition;
+        int v;
+    public:
+        // Current superstep, from 0.
+        int superstep() const { return engine->step; }
+        // Id of the vertex being computed, and the number of vertices.
+        int vertex() const { return v; }
+        int numVertices() const { return engine->graph.rows; }
+        // Value of the vertex, modifiable.
+        Value& value() { return engine->values[v]; }
+        // Whether any message arrived, and the combination of all of them.
+        bool hasMessage() const { return engine->has_message[v]; }
+        const Message& message() const { return engine->inbox[v]; }
+        // Out edges of the vertex.
+        int degree() const { return engine->graph.rowSize(v); }
+        const int* neighbors() const { return engine->graph.rowIndices(v); }
+        const E* edgeValues() const { return engine->graph.rowValues(v); }
+        // Sends a message to be received in the next superstep.
+        void sendTo(int target, const Message& m) {
+            engine->send(partition, target, m);
+        }
+        void sendToNeighbors(const Message& m) {
+            const int* adj = neighbors();
+            for (int k = 0; k < degree(); k++)
+                engine->send(partition, adj[k], m);
+        }
+        // Halts the vertex until it receives a message.
+        void voteToHalt() { engine->halted[v] = 1; }
+        // Contributes to the aggregate visible in the next superstep.
+        void aggregate(const Aggregate& a) {
+            engine->partials[partition] =
+                engine->aggregator(engine->partials[partition], a);
+        }
+        // Aggregate of all contributions made in the previous superstep.
+        const Aggregate& aggregated() const { return engine->aggregated; }
+    };
+
+    /*
+     * Creates an engine over graph with every vertex holding initial and
+     * active.
+     *
+     * Parameters:
+     *  graph -
+     *      Square matrix of out edges. Must outlive the engine.
+     *  initial -
+     *      Starting value of every vertex.
+     *  aggregate_zero -
+     *      Identity of the aggregator.
+     *  partitions -
+     *      Number of vertex partitions, 0 for four per thread.
+     */
+    PregelEngine(const CsrMatrix<E>& g, const Value& initial,
+                 const Aggregate& aggregate_zero = Aggregate(),
+                 int partitions = 0)
+        : graph(g), values(g.rows, initial), inbox(g.rows),
+          has_message(g.rows, 0), halted(g.rows, 0), zero(aggregate_zero),
+          aggregated(aggregate_zero) {
+        num_parts = partitions > 0 ? partitions : 4 * numThreads();
+        num_parts = max(1, min(num_parts, max(1, g.rows)));
+        part_size = (g.rows + num_parts - 1) / num_parts;
+        if (part_size == 0)
+            part_size = 1;
+        outbox.assign(num_parts,
+                      vector<vector<pair<int, Message>>>(num_parts));
+        partials.assign(num_parts, zero);
+    }
+
+    /*
+     * Runs supersteps until every vertex halts with no messages in flight, or
+     * max_supersteps have run.
+     *
+     * Parameters:
+     *  compute -
+     *      void (Context&) called for each active vertex.
+     *  max_supersteps -
+     *      Upper bound on supersteps, negative for none.
+     *
+     * Returns:
+     *  int -
+     *      Number of supersteps run.
+     */
+    template <class Compute>
+    int run(Compute compute, int max_supersteps = -1) {
+        for (step = 0; max_supersteps < 0 || step < max_supersteps; step++) {
+            // Compute every active vertex, partitions in parallel
+            vector<char> any_active(num_parts, 0);
+            parallelFor(0, num_parts, 1, [&](int lo, int hi, int) {
+                for (int p = lo; p < hi; p++)
+                    computePartition(compute, p, any_active);
+            });
+            if (find(any_active.begin(), any_active.end(), 1) ==
+                any_active.end())
+                break;
+
+            // Combine the aggregate and deliver messages to their partitions
+            aggregated = zero;
+            for (int p = 0; p < num_parts; p++) {
+                aggregated = aggregator(aggregated, partials[p]);
+                partials[p] = zero;
+            }
+            fill(has_message.begin(), has_message.end(), 0);
+            parallelFor(0, num_parts, 1, [&](int lo, int hi, int) {
+                for (int q = lo; q < hi; q++)
+                    deliverPartition(q);
+            });
+        }
+        return step;
+    }
+
+    // Final vertex values.
+    const vector<Value>& result() const { return values; }
+
+private:
+    const CsrMatrix<E>& graph;
+    vector<Value> values;
+    vector<Message> inbox;
+    vector<char> has_message;
+    vector<char> halted;
+    // outbox[p][q] holds messages sent from partition p to partition q
+    vector<vector<vector<pair<int, Message>>>> outbox;
+    vector<Aggregate> partials;
+    Aggregate zero;
+    Aggregate aggregated;
+    Combiner combiner;
+    Aggregator aggregator;
+    int num_parts;
+    int part_size;
+    int step = 0;
+
+    // Runs compute for the active vertices of partition p.
+    template <class Compute>
+    void computePartition(Compute& compute, int p, vector<char>& any_active) {
+        Context c;
+        c.engine = this;
+        c.partition = p;
+        int hi = min(graph.rows, (p + 1) * part_size);
+        for (int v = p * part_size; v < hi; v++) {
+            if (halted[v] && !has_message[v])
+                continue;
+            halted[v] = 0;
+            any_active[p] = 1;
+            c.v = v;
+            compute(c);
+        }
+    }
+
+    // Combines the messages sent to partition q into its inboxes.
+    void deliverPartition(int q) {
+        for (int p = 0; p < num_parts; p++) {
+            for (auto& sent : outbox[p][q]) {
+                int v = sent.first;
+                if (has_message[v]) {
+                    inbox[v] = combiner(inbox[v], sent.second);
+                } else {
+                    inbox[v] = sent.second;
+                    has_message[v] = 1;
+                }
+            }
+            outbox[p][q].clear();
+        }
+    }
+
+    // Queues m for target in the outbox of the sending partition.
+    void send(int partition, int target, const Message& m) {
+        outbox[partition][target / part_size].push_back(
+            pair<int, Message>(target, m));
+    }
+};
+
+#endif  // PREGEL_HPP
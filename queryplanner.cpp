@@ -0,0 +1,382 @@
+/*
+ * This file implements the query planner declared in queryplanner.hpp.
+ */
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <vector>
+#include "actorgraph.hpp"
+#include "distancesketch.hpp"
+#include "pathbatch.hpp"
+#include "queryplanner.hpp"
+#include "trace.hpp"
+#include "traversal.hpp"
+
+using namespace std;
+
+const char* const ENGINE_NAMES[NUM_ENGINES] = {"none", "sketch",
+                                               "bidirectional", "dijkstra"};
+
+// Names of the pair queries, in PairQuery order
+static const char* const QUERY_NAMES[] = {"path", "distance", "estimate"};
+
+// Number of actors whose hops to every other actor are sampled
+const static int HOP_SAMPLES = 8;
+
+
+// Root of x in a union-find forest, halving paths as it goes.
+static int FindRoot(vector<int>& parent, int x) {
+    while (parent[x] != x)
+        x = parent[x] = parent[parent[x]];
+    return x;
+}
+
+// Roles scanned expanding actor v: its movies and their casts.
+static long long ExpandCost(const ActorGraph& graph, int v) {
+    long long cost = graph.moviesOf(v).size();
+    for (int m : graph.moviesOf(v))
+        cost += graph.castOf(m).size();
+    return cost;
+}
+
+
+/*
+ * Builds the statistics of graph: components by union-find over the casts,
+ * and from breadth first searches from a few actors spread over the ids,
+ * the mean hops and the growth in roles scanned from the first level of a
+ * search to the second.
+ *
+ * Parameters:
+ *  graph -
+ *      Loaded graph.
+ *  weighted -
+ *      Whether the graph was loaded with weighted movies.
+ *  sketch -
+ *      Sketches of graph, or null.
+ */
+void PlannerIndex::build(const ActorGraph& graph, bool is_weighted,
+                         const DistanceSketch* sketches) {
+    TRACE_SCOPE("planner index");
+    int num_actors = graph.numActors();
+    weighted = is_weighted;
+    sketch = sketches;
+
+    component.resize(num_actors);
+    iota(component.begin(), component.end(), 0);
+    all_roles = 0;
+    for (int m = 0; m < graph.numMovies(); m++) {
+        IdRange cast = graph.castOf(m);
+        all_roles += 2 * (long long)cast.size();
+        for (int c : cast) {
+            int x = FindRoot(component, c);
+            int y = FindRoot(component, *cast.begin());
+            if (x != y)
+                component[max(x, y)] = min(x, y);
+        }
+    }
+    for (int v = 0; v < num_actors; v++)
+        component[v] = FindRoot(component, v);
+
+    // Roles scanned expanding the actors at each hop, the movies of each
+    // actor and the casts of the movies it was first to expand
+    SearchState state(graph);
+    double hop_sum = 0;
+    long long pairs = 0;
+    long long level_work[2] = {0, 0};
+    int samples = min(HOP_SAMPLES, num_actors);
+    for (int i = 0; i < samples; i++) {
+        state.reset();
+        FifoFrontier frontier(state);
+        addSource(state, frontier, (int)((long long)i * num_actors / samples));
+        TraversalVisitor visitor;
+        traverse(graph, state, frontier, UnitWeight(), visitor);
+        for (int v : state.touched) {
+            hop_sum += state.dist[v];
+            pairs += state.dist[v] > 0;
+            if (state.dist[v] < 2)
+                level_work[state.dist[v]] += graph.moviesOf(v).size();
+        }
+        for (int m : state.touched_movies) {
+            if (state.movie_dist[m] < 2)
+                level_work[state.movie_dist[m]] += graph.castOf(m).size();
+        }
+    }
+    mean_hops = pairs ? max(1.0, hop_sum / pairs) : 1;
+    growth = level_work[0] ? max(1.0, (double)level_work[1] / level_work[0])
+                           : 1;
+}
+
+
+/*
+ * Opens a file to receive a line per query.
+ *
+ * Returns:
+ *  bool -
+ *      True if the file was opened.
+ */
+bool PlanLog::open(const string& filename) {
+    out.open(filename);
+    out << "Row\tQuery\tEngine\tEstimated roles\tActual roles\n";
+    return (bool)out;
+}
+
+
+/*
+ * Adds the plans of a batch of queries to the totals and the log file.
+ *
+ * Parameters:
+ *  first_row -
+ *      Row of the first query.
+ *  query -
+ *      Query asked of every row.
+ *  plans, work -
+ *      Plan and roles actually scanned of each query.
+ */
+void PlanLog::add(size_t first_row, PairQuery query, const vector<Plan>& plans,
+                  const vector<long long>& work) {
+    lock_guard<mutex> hold(lock);
+    for (size_t i = 0; i < plans.size(); i++) {
+        Engine e = plans[i].engine;
+        queries[e]++;
+        estimated[e] += plans[i].estimated;
+        actual[e] += work[i];
+        if (out.is_open()) {
+            out << first_row + i << '\t' << QUERY_NAMES[query] << '\t'
+                << ENGINE_NAMES[e] << '\t' << llround(plans[i].estimated)
+                << '\t' << work[i] << '\n';
+        }
+    }
+}
+
+
+QueryPlanner::QueryPlanner(const ActorGraph& g, const PlannerIndex& i,
+                           const Exclusions* a, PathSearcher& s)
+    : graph(g), index(i), avoid(a), searcher(s), state(g),
+      buckets(state, i.bucket_width) {}
+
+
+// Estimated roles scanned searching r hops out from actor v.
+double QueryPlanner::ballCost(int v, double r) const {
+    if (r <= 0)
+        return 0;
+    double cost = ExpandCost(graph, v) * pow(index.growth, r - 1);
+    return min(cost, (double)index.all_roles);
+}
+
+
+/*
+ * Chooses the cheapest engine able to answer a query exactly, or the sketch
+ * for estimates. See queryplanner.hpp.
+ *
+ * Parameters:
+ *  query -
+ *      Query asked.
+ *  start, end -
+ *      Actor ids, -1 for unknown actors.
+ *
+ * Returns:
+ *  Plan -
+ *      Engine chosen and its estimated cost.
+ */
+Plan QueryPlanner::plan(PairQuery query, int start, int end) const {
+    Plan best;
+    if (start < 0 || end < 0 ||
+        (avoid && (avoid->hasActor(start) || avoid->hasActor(end))) ||
+        index.component[start] != index.component[end] ||
+        (query != PATH_PAIR && start == end))
+        return best;
+
+    // Hops the search must cover, from the sketch if built
+    int sketch_hops = index.sketch ? index.sketch->estimate(start, end) : -1;
+    int hops = sketch_hops > 0 ? sketch_hops
+                               : max(1, (int)lround(index.mean_hops));
+
+    // Lengths are hops, except exact distances of weighted graphs
+    bool by_hops = query == ESTIMATE_PAIR || !index.weighted;
+    double best_time = 0;
+    auto consider = [&](Engine engine, double cost) {
+        double time = cost * index.scale[engine];
+        if (index.enabled[engine] &&
+            (best.engine == NO_SEARCH || time < best_time)) {
+            best.engine = engine;
+            best.estimated = cost;
+            best_time = time;
+        }
+    };
+    if (query != ESTIMATE_PAIR || !index.weighted)
+        consider(DIJKSTRA, ballCost(start, hops));
+    if (query == PATH_PAIR)
+        return best;
+    if (by_hops) {
+        // Each level expands the side with the cheaper frontier, as the
+        // search does
+        double frontier[2] = {ballCost(start, 1), ballCost(end, 1)};
+        double cost = 0;
+        for (int level = 0; level < hops; level++) {
+            double& cheaper = frontier[frontier[1] < frontier[0]];
+            cost += cheaper;
+            cheaper *= index.growth;
+        }
+        consider(BIDIRECTIONAL_BFS, min(cost, (double)index.all_roles));
+    }
+    // The sketch answers estimates of actors sharing a seed, and proves hops
+    // of 1 exact. Connected actors sharing none are searched instead.
+    if (index.sketch && !avoid && sketch_hops > 0 &&
+        (query == ESTIMATE_PAIR || (!index.weighted && sketch_hops == 1)))
+        consider(SKETCH_LOOKUP, 2.0 * index.sketch->numSets());
+    return best;
+}
+
+
+/*
+ * Hops between two distinct actors by breadth first search from both, a
+ * whole level of the side with fewer movies to expand at a time. Once a
+ * level reaches actors the other side has reached, the fewest hops through
+ * any of them is the answer.
+ */
+int QueryPlanner::bidirectionalHops(int start, int end, long long& work) {
+    if (seen[0].empty()) {
+        for (int side = 0; side < 2; side++) {
+            seen[side].assign(graph.numActors(), 0);
+            hops[side].assign(graph.numActors(), 0);
+            movie_seen[side].assign(graph.numMovies(), 0);
+        }
+    }
+    stamp++;
+    vector<int> frontier[2] = {vector<int>(1, start), vector<int>(1, end)};
+    int depth[2] = {0, 0};
+    seen[0][start] = stamp;
+    hops[0][start] = 0;
+    seen[1][end] = stamp;
+    hops[1][end] = 0;
+
+    vector<int> next;
+    while (!frontier[0].empty() && !frontier[1].empty()) {
+        long long movies[2] = {0, 0};
+        for (int side = 0; side < 2; side++) {
+            for (int v : frontier[side])
+                movies[side] += graph.moviesOf(v).size();
+        }
+        int side = movies[0] <= movies[1] ? 0 : 1;
+        int other = 1 - side;
+        work += movies[side];
+
+        int best = INT_MAX;
+        next.clear();
+        for (int v : frontier[side]) {
+            for (int m : graph.moviesOf(v)) {
+                if (movie_seen[side][m] == stamp ||
+                    (avoid && avoid->hasMovie(m)))
+                    continue;
+                movie_seen[side][m] = stamp;
+                work += graph.castOf(m).size();
+                for (int c : graph.castOf(m)) {
+                    if (avoid && avoid->hasActor(c))
+                        continue;
+                    if (seen[other][c] == stamp)
+                        best = min(best, depth[side] + 1 + hops[other][c]);
+                    if (seen[side][c] != stamp) {
+                        seen[side][c] = stamp;
+                        hops[side][c] = depth[side] + 1;
+                        next.push_back(c);
+                    }
+                }
+            }
+        }
+        if (best != INT_MAX)
+            return best;
+        frontier[side].swap(next);
+        depth[side]++;
+    }
+    return -1;
+}
+
+
+// Distance between two actors by the search of findPath, -1 if none. Only
+// the distance is needed, so actors are ordered by buckets of distance,
+// movie weights being small integers, rather than by findPath's heap.
+int QueryPlanner::dijkstraDistance(int start, int end, long long& work) {
+    state.reset();
+    buckets.clear();
+    addSource(state, buckets, start);
+    int last;
+    if (avoid) {
+        AvoidingVisitor<TargetVisitor> visitor(avoid, TargetVisitor(end));
+        last = traverse(graph, state, buckets, MovieWeight(), visitor);
+    } else {
+        TargetVisitor visitor(end);
+        last = traverse(graph, state, buckets, MovieWeight(), visitor);
+    }
+    work += searchWork(graph, state);
+    return last == end ? state.dist[end] : -1;
+}
+
+
+/*
+ * Plans and answers a batch of queries. Paths are found together by the
+ * path searcher, so they may be interleaved.
+ *
+ * Parameters:
+ *  query -
+ *      Query asked of every pair.
+ *  pairs -
+ *      Starting and ending actor ids; -1 for an unknown actor.
+ *  answers -
+ *      Receives each answer, empty if the actors are not connected.
+ *  log -
+ *      Log receiving the plans and their actual costs, or null.
+ *  first_row -
+ *      Row of the first pair, for the log.
+ */
+void QueryPlanner::answer(PairQuery query, const vector<pair<int, int>>& pairs,
+                          vector<string>& answers, PlanLog* log,
+                          size_t first_row) {
+    int n = (int)pairs.size();
+    answers.assign(n, string());
+    vector<Plan> plans(n);
+    vector<long long> work(n, 0);
+    for (int i = 0; i < n; i++)
+        plans[i] = plan(query, pairs[i].first, pairs[i].second);
+
+    if (query == PATH_PAIR) {
+        vector<pair<int, int>> searched(pairs);
+        for (int i = 0; i < n; i++) {
+            if (plans[i].engine == NO_SEARCH)
+                searched[i] = pair<int, int>(-1, -1);
+        }
+        searcher.find(searched, 0, n, answers, &work);
+    } else {
+        for (int i = 0; i < n; i++) {
+            int start = pairs[i].first;
+            int end = pairs[i].second;
+            int length = -1;
+            switch (plans[i].engine) {
+            case NO_SEARCH:
+                if (start >= 0 && start == end &&
+                    !(avoid && avoid->hasActor(start)))
+                    length = 0;
+                break;
+            case SKETCH_LOOKUP:
+                length = index.sketch->estimate(start, end);
+                work[i] = 2 * index.sketch->numSets();
+                break;
+            case BIDIRECTIONAL_BFS:
+                length = bidirectionalHops(start, end, work[i]);
+                break;
+            case DIJKSTRA:
+                length = dijkstraDistance(start, end, work[i]);
+                break;
+            case NUM_ENGINES:
+                break;
+            }
+            if (length >= 0)
+                answers[i] = to_string(length);
+        }
+    }
+    if (log)
+        log->add(first_row, query, plans, work);
+}
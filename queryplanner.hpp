@@ -0,0 +1,231 @@
+/*
+ * This file declares the query planner, which answers queries between two
+ * actors with the cheapest engine able to answer them exactly, so callers
+ * need not choose. Engines:
+ *
+ *  none          - no search: an actor is unknown or excluded, the two are
+ *                  in different components, or the length asked is from an
+ *                  actor to itself.
+ *  sketch        - a lookup in the distance sketches (distancesketch.hpp).
+ *  bidirectional - breadth first search from both actors at once, meeting
+ *                  in the middle. Hops only.
+ *  dijkstra      - the search of findPath, from the first actor until the
+ *                  second is settled. Lengths alone are searched over
+ *                  buckets of distance (see BucketFrontier).
+ *
+ * Each engine is costed in roles scanned, the work of expanding an actor's
+ * movies or a movie's cast. Searching out r hops from actor s is estimated
+ * as min(all roles, w(s) g^(r - 1)), where w(s) is the roles scanned
+ * expanding s and g the growth in roles scanned from the first hop of a
+ * search to the second, measured from a sample of actors. The hops r come
+ * from the sketches if built, otherwise from the mean hops of the sample.
+ * Searching from both actors, each level is costed as the cheaper of the two
+ * frontiers, which the search expands next. Engines are compared by these
+ * costs times their time per role, as calibrated on the host (tuning.hpp),
+ * or as is if not calibrated.
+ *
+ * Which engines may answer depends on the query:
+ *
+ *  path     - dijkstra only, so paths and their ties are exactly those of
+ *             findPath.
+ *  distance - bidirectional or dijkstra on unweighted graphs, the sketch
+ *             when it proves the actors co-star; dijkstra on weighted ones.
+ *  estimate - the sketch if built, nothing is excluded and the actors'
+ *             sketches share a seed, otherwise the exact hops as for an
+ *             unweighted distance.
+ *
+ * Every choice is recorded with its estimated and actual cost, so the cost
+ * model can be tuned from the log.
+ */
+
+#ifndef QUERYPLANNER_HPP
+#define QUERYPLANNER_HPP
+
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "actorgraph.hpp"
+#include "distancesketch.hpp"
+#include "memory.hpp"
+#include "pathbatch.hpp"
+#include "traversal.hpp"
+
+using namespace std;
+
+// Queries between two actors the planner answers.
+enum PairQuery { PATH_PAIR, DISTANCE_PAIR, ESTIMATE_PAIR };
+
+// Engines answering pair queries.
+enum Engine { NO_SEARCH, SKETCH_LOOKUP, BIDIRECTIONAL_BFS, DIJKSTRA,
+              NUM_ENGINES };
+
+// Names of the engines, in Engine order.
+extern const char* const ENGINE_NAMES[NUM_ENGINES];
+
+/*
+ * Statistics and indexes of a graph the planner chooses from, built once
+ * and shared read only by every planner.
+ */
+struct PlannerIndex {
+    // Component of each actor, and whether movies are weighted
+    vector<int> component;
+    bool weighted = false;
+    // Roles scanned by a search of the whole graph, the growth in roles
+    // scanned per hop, and the mean hops between sampled actors
+    long long all_roles = 0;
+    double growth = 1;
+    double mean_hops = 1;
+    // Distance sketches, or null if not built
+    const DistanceSketch* sketch = nullptr;
+    // Time of each engine per role it scans, as calibrated by the
+    // analyzer's autotune mode, and whether it may be chosen
+    double scale[NUM_ENGINES] = {1, 1, 1, 1};
+    bool enabled[NUM_ENGINES] = {true, true, true, true};
+    // Width of the distance buckets of dijkstra (see BucketFrontier)
+    int bucket_width = 1;
+
+    /*
+     * Builds the statistics of graph.
+     *
+     * Parameters:
+     *  graph -
+     *      Loaded graph.
+     *  weighted -
+     *      Whether the graph was loaded with weighted movies.
+     *  sketch -
+     *      Sketches of graph, or null. Must outlive the index.
+     */
+    void build(const ActorGraph& graph, bool weighted,
+               const DistanceSketch* sketch);
+
+    // Bytes held by the statistics, not counting the sketches.
+    size_t bytes() const { return memoryBytes(component); }
+};
+
+// Engine chosen for a query, with its estimated cost in roles scanned.
+struct Plan {
+    Engine engine = NO_SEARCH;
+    double estimated = 0;
+};
+
+/*
+ * Log of the plans of a run, shared by every planner: per engine totals and,
+ * if opened, a line per query. Safe to share between threads.
+ */
+class PlanLog {
+private:
+    mutex lock;
+    ofstream out;
+
+public:
+    // Queries, estimated and actual roles scanned of each engine
+    long long queries[NUM_ENGINES] = {};
+    double estimated[NUM_ENGINES] = {};
+    long long actual[NUM_ENGINES] = {};
+
+    /*
+     * Opens a file to receive a tab separated line per query: row, query,
+     * engine, estimated and actual roles scanned.
+     *
+     * Returns:
+     *  bool -
+     *      True if the file was opened.
+     */
+    bool open(const string& filename);
+
+    /*
+     * Adds the plans of a batch of queries.
+     *
+     * Parameters:
+     *  first_row -
+     *      Row of the first query, counting from 0 after the header.
+     *  query -
+     *      Query asked of every row.
+     *  plans, work -
+     *      Plan and roles actually scanned of each query.
+     */
+    void add(size_t first_row, PairQuery query, const vector<Plan>& plans,
+             const vector<long long>& work);
+};
+
+/*
+ * Planner of one thread, holding the scratch space of the engines between
+ * queries. Not safe to share between threads.
+ */
+class QueryPlanner {
+private:
+    const ActorGraph& graph;
+    const PlannerIndex& index;
+    const Exclusions* avoid;
+    PathSearcher& searcher;
+    SearchState state;
+    BucketFrontier buckets;
+
+    // Bidirectional search labels of each side: stamp of the query an actor
+    // or movie was reached in, and the hops of reached actors
+    int stamp = 0;
+    vector<int> seen[2];
+    vector<int> movie_seen[2];
+    vector<int> hops[2];
+
+    // Estimated roles scanned searching r hops out from actor v
+    double ballCost(int v, double r) const;
+
+    // Hops between two actors by each engine, -1 if not connected, adding
+    // the roles scanned to work
+    int bidirectionalHops(int start, int end, long long& work);
+    int dijkstraDistance(int start, int end, long long& work);
+
+public:
+    /*
+     * Parameters:
+     *  graph -
+     *      Loaded graph.
+     *  index -
+     *      Statistics and indexes of graph.
+     *  avoid -
+     *      Actors and movies no answer may pass through, or null.
+     *  searcher -
+     *      Path searcher of the calling thread, answering path queries.
+     *  All must outlive the planner.
+     */
+    QueryPlanner(const ActorGraph& graph, const PlannerIndex& index,
+                 const Exclusions* avoid, PathSearcher& searcher);
+
+    /*
+     * Chooses the engine answering a query.
+     *
+     * Parameters:
+     *  query -
+     *      Query asked.
+     *  start, end -
+     *      Actor ids, -1 for unknown actors.
+     *
+     * Returns:
+     *  Plan -
+     *      Cheapest engine able to answer the query, and its cost.
+     */
+    Plan plan(PairQuery query, int start, int end) const;
+
+    /*
+     * Plans and answers a batch of queries.
+     *
+     * Parameters:
+     *  query -
+     *      Query asked of every pair.
+     *  pairs -
+     *      Starting and ending actor ids; -1 for an unknown actor.
+     *  answers -
+     *      Receives each answer: the path as formatted by findPath, or the
+     *      distance or estimate. Empty if the actors are not connected.
+     *  log -
+     *      Log receiving the plans and their actual costs, or null.
+     *  first_row -
+     *      Row of the first pair, for the log.
+     */
+    void answer(PairQuery query, const vector<pair<int, int>>& pairs,
+                vector<string>& answers, PlanLog* log, size_t first_row);
+};
+
+#endif  // QUERYPLANNER_HPP
@@ -0,0 +1,125 @@
+/*
+ * This file implements RankIndex, an index ranking actors by how connected
+ * they are, overall and within each decade. See rankindex.hpp.
+ */
+
+#include <algorithm>
+#include <climits>
+#include <vector>
+#include "actorgraph.hpp"
+#include "parallel.hpp"
+#include "rankindex.hpp"
+
+using namespace std;
+
+
+/*
+ * Builds the index for graph using numThreads() threads.
+ *
+ * Parameters:
+ *  graph -
+ *      Loaded graph to rank the actors of.
+ */
+void RankIndex::build(const ActorGraph& graph) {
+    num_actors = graph.numActors();
+
+    // Find the decades spanned by the movies
+    int min_year = INT_MAX;
+    int max_year = INT_MIN;
+    for (int m = 0; m < graph.numMovies(); m++) {
+        min_year = min(min_year, graph.movieYear(m));
+        max_year = max(max_year, graph.movieYear(m));
+    }
+    first_decade = graph.numMovies() ? min_year / 10 * 10 : 0;
+    num_periods = 1 + (graph.numMovies() ? max_year / 10 - min_year / 10 + 1
+                                         : 0);
+    values.assign(NUM_METRICS * num_periods, vector<int>(num_actors, 0));
+
+    // Compute every metric of every actor. Distinct co-stars are counted by
+    // stamping each co-star seen, overall with the actor's id and within a
+    // period with a running count, so no marks are ever cleared.
+    vector<vector<int>> seen(numThreads());
+    vector<vector<int>> seen_in_period(numThreads());
+    vector<int> next_stamp(numThreads(), 0);
+    parallelFor(0, num_actors, 256, [&](int lo, int hi, int t) {
+        if (seen[t].empty()) {
+            seen[t].assign(num_actors, -1);
+            seen_in_period[t].assign(num_actors, -1);
+        }
+        vector<pair<int, int>> by_period;
+
+        for (int a = lo; a < hi; a++) {
+            // Movies of the actor grouped by period
+            by_period.clear();
+            for (int m : graph.moviesOf(a))
+                by_period.push_back(pair<int, int>(
+                    period(graph.movieYear(m) / 10 * 10), m));
+            sort(by_period.begin(), by_period.end());
+
+            size_t i = 0;
+            while (i < by_period.size()) {
+                int p = by_period[i].first;
+                int stamp = next_stamp[t]++;
+                for (; i < by_period.size() && by_period[i].first == p; i++) {
+                    IdRange cast = graph.castOf(by_period[i].second);
+                    for (int q : {0, p}) {
+                        values[slot(DEGREE, q)][a] += cast.size() - 1;
+                        values[slot(MOVIES, q)][a]++;
+                    }
+                    for (int c : cast) {
+                        if (c == a)
+                            continue;
+                        if (seen_in_period[t][c] != stamp) {
+                            seen_in_period[t][c] = stamp;
+                            values[slot(COSTARS, p)][a]++;
+                        }
+                        if (seen[t][c] != a) {
+                            seen[t][c] = a;
+                            values[slot(COSTARS, 0)][a]++;
+                        }
+                    }
+                }
+            }
+        }
+    });
+
+    // Sort the actors of every metric and period by rank
+    order.assign(NUM_METRICS * num_periods, vector<int>());
+    ranks.assign(NUM_METRICS * num_periods, vector<int>(num_actors, -1));
+    parallelFor(0, NUM_METRICS * num_periods, 1, [&](int lo, int hi, int) {
+        for (int s = lo; s < hi; s++) {
+            const vector<int>& value = values[s];
+            for (int a = 0; a < num_actors; a++) {
+                if (value[a] > 0)
+                    order[s].push_back(a);
+            }
+            sort(order[s].begin(), order[s].end(), [&value](int x, int y) {
+                if (value[x] != value[y])
+                    return value[x] > value[y];
+                return x < y;
+            });
+            for (int r = 0; r < (int)order[s].size(); r++)
+                ranks[s][order[s][r]] = r;
+        }
+    });
+}
+
+
+/*
+ * Period of a decade. Period 0 covers all years.
+ *
+ * Parameters:
+ *  decade -
+ *      Any year of the decade, e.g. 1990 or 1994 for the 1990s.
+ *
+ * Returns:
+ *  int -
+ *      The period of the decade, or -1 if no movie is from the decade.
+ */
+int RankIndex::period(int decade) const {
+    decade = decade / 10 * 10;
+    if (decade < first_decade)
+        return -1;
+    int p = 1 + (decade - first_decade) / 10;
+    return p < num_periods ? p : -1;
+}
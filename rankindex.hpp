@@ -0,0 +1,97 @@
+/*
+ * This file declares RankIndex, an index ranking actors by how connected they
+ * are, overall and within each decade. Three metrics are ranked:
+ *
+ *  DEGREE   - co-star links counted once per shared movie, the sum over an
+ *             actor's movies of the cast size less one.
+ *  COSTARS  - distinct co-stars.
+ *  MOVIES   - movies appeared in.
+ *
+ * The index is built in parallel once the graph is loaded and holds, for each
+ * metric and period, the actors in rank order and each actor's rank, so the
+ * top N actors are a prefix of an array and the rank of an actor one lookup.
+ */
+
+#ifndef RANKINDEX_HPP
+#define RANKINDEX_HPP
+
+#include <vector>
+#include "actorgraph.hpp"
+#include "memory.hpp"
+
+using namespace std;
+
+// Metrics actors are ranked by.
+enum RankMetric { DEGREE, COSTARS, MOVIES, NUM_METRICS };
+
+class RankIndex {
+private:
+    // Decade of the first period after the overall one, and period count.
+    int first_decade = 0;
+    int num_periods = 0;
+    int num_actors = 0;
+
+    // For each metric and period, at [metric * num_periods + period]:
+    //  values  - metric value of every actor, by actor id.
+    //  order   - actors with a non-zero value, highest value then lowest id.
+    //  ranks   - position of every actor in order, -1 if not ranked.
+    vector<vector<int>> values;
+    vector<vector<int>> order;
+    vector<vector<int>> ranks;
+
+    // Index of the metric, period arrays.
+    int slot(RankMetric metric, int period) const {
+        return (int)metric * num_periods + period;
+    }
+
+public:
+    /*
+     * Builds the index for graph using numThreads() threads.
+     *
+     * Parameters:
+     *  graph -
+     *      Loaded graph to rank the actors of.
+     */
+    void build(const ActorGraph& graph);
+
+    /*
+     * Period of a decade, for the accessors beneath. Period 0 covers all
+     * years.
+     *
+     * Parameters:
+     *  decade -
+     *      Any year of the decade, e.g. 1990 or 1994 for the 1990s.
+     *
+     * Returns:
+     *  int -
+     *      The period of the decade, or -1 if no movie is from the decade.
+     */
+    int period(int decade) const;
+
+    // Number of actors ranked in a period, those with a non-zero value.
+    int numRanked(RankMetric metric, int period) const {
+        return (int)order[slot(metric, period)].size();
+    }
+
+    // Actor at rank r of a period, from 0.
+    int actorAt(RankMetric metric, int period, int r) const {
+        return order[slot(metric, period)][r];
+    }
+
+    // Rank of an actor within a period from 0, or -1 if not ranked.
+    int rankOf(RankMetric metric, int period, int actor) const {
+        return ranks[slot(metric, period)][actor];
+    }
+
+    // Metric value of an actor within a period.
+    int valueOf(RankMetric metric, int period, int actor) const {
+        return values[slot(metric, period)][actor];
+    }
+
+    // Bytes held by the values, orders and ranks of every period.
+    size_t bytes() const {
+        return memoryBytes(values) + memoryBytes(order) + memoryBytes(ranks);
+    }
+};
+
+#endif  // RANKINDEX_HPP
@@ -0,0 +1,439 @@
+/*
+ * This file contains a small sparse linear algebra layer in the style of
+ * GraphBLAS. Graph kernels are written as matrix products over a semiring,
+ * which supplies the "add" and "multiply" of the product:
+ *
+ *  PlusTimes   - ordinary arithmetic, e.g. weighted degree.
+ *  PlusPair    - multiply yields 1 for every pair of stored entries, so a
+ *                product counts common neighbours or live neighbours.
+ *  OrAnd       - boolean reachability, e.g. BFS frontiers or projections.
+ *  MinPlus     - shortest path relaxation.
+ *
+ * Matrices are stored in compressed sparse row (CSR) form. A compressed
+ * sparse column matrix is the CSR form of its transpose, see transpose.
+ * Products accumulate into dense per thread arrays indexed by column, so
+ * each entry of a row is combined in place without hashing or sorting, and
+ * rows are distributed over threads with parallelFor.
+ */
+
+#ifndef SPARSEMATRIX_HPP
+#define SPARSEMATRIX_HPP
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include "memory.hpp"
+#include "parallel.hpp"
+
+using namespace std;
+
+// Sparse matrix in compressed sparse row form.
+template <class T>
+struct CsrMatrix {
+    int rows = 0;
+    int cols = 0;
+    // Entries of row i are at [offsets[i], offsets[i+1]) of indices and
+    // values, with column indices increasing within each row.
+    vector<int> offsets = vector<int>(1, 0);
+    vector<int> indices;
+    vector<T> values;
+
+    // Number of stored entries.
+    long long nnz() const { return (long long)indices.size(); }
+    // Number of stored entries in row i.
+    int rowSize(int i) const { return offsets[i + 1] - offsets[i]; }
+    // Column indices and values of row i.
+    const int* rowIndices(int i) const { return indices.data() + offsets[i]; }
+    const T* rowValues(int i) const { return values.data() + offsets[i]; }
+    // Bytes held by the arrays, by capacity.
+    size_t bytes() const {
+        return memoryBytes(offsets) + memoryBytes(indices) +
+               memoryBytes(values);
+    }
+};
+
+// Compressed sparse column matrix, stored as the CSR form of its transpose.
+template <class T>
+using CscMatrix = CsrMatrix<T>;
+
+// Sparse vector of given size holding entries at increasing indices.
+template <class T>
+struct SparseVector {
+    int size = 0;
+    vector<int> indices;
+    vector<T> values;
+};
+
+
+// Semirings. add must be associative and commutative with identity zero().
+template <class T>
+struct PlusTimes {
+    typedef T value_type;
+    static T zero() { return T(0); }
+    static T add(T x, T y) { return x + y; }
+    template <class A, class B>
+    static T mul(A a, B b) { return T(a) * T(b); }
+};
+
+template <class T>
+struct PlusPair {
+    typedef T value_type;
+    static T zero() { return T(0); }
+    static T add(T x, T y) { return x + y; }
+    template <class A, class B>
+    static T mul(A, B) { return T(1); }
+};
+
+struct OrAnd {
+    typedef char value_type;
+    static char zero() { return 0; }
+    static char add(char x, char y) { return x | y; }
+    template <class A, class B>
+    static char mul(A a, B b) { return (a != A(0)) & (b != B(0)); }
+};
+
+template <class T>
+struct MinPlus {
+    typedef T value_type;
+    static T zero() { return numeric_limits<T>::max(); }
+    static T add(T x, T y) { return x < y ? x : y; }
+    template <class A, class B>
+    static T mul(A a, B b) {
+        if (T(a) == zero() || T(b) == zero())
+            return zero();
+        return T(a) + T(b);
+    }
+};
+
+
+/*
+ * Builds a CSR matrix from (row, column, value) triples. Duplicate entries
+ * are combined with the semiring's add.
+ *
+ * Parameters:
+ *  rows, cols -
+ *      Dimensions of the matrix.
+ *  triples -
+ *      Entries of the matrix, in any order.
+ */
+template <class Semiring, class T>
+CsrMatrix<T> fromTriples(int rows, int cols,
+                         vector<pair<pair<int, int>, T>> triples) {
+    sort(triples.begin(), triples.end(),
+         [](const pair<pair<int, int>, T>& x,
+            const pair<pair<int, int>, T>& y) { return x.first < y.first; });
+    CsrMatrix<T> m;
+    m.rows = rows;
+    m.cols = cols;
+    m.offsets.assign(rows + 1, 0);
+    for (size_t i = 0; i < triples.size(); i++) {
+        if (i && triples[i].first == triples[i - 1].first) {
+            m.values.back() = Semiring::add(m.values.back(),
+                                            triples[i].second);
+            continue;
+        }
+        m.offsets[triples[i].first.first + 1]++;
+        m.indices.push_back(triples[i].first.second);
+        m.values.push_back(triples[i].second);
+    }
+    for (int i = 0; i < rows; i++)
+        m.offsets[i + 1] += m.offsets[i];
+    return m;
+}
+
+// Returns the transpose of m, equivalently the CSC form of m.
+template <class T>
+CsrMatrix<T> transpose(const CsrMatrix<T>& m) {
+    CsrMatrix<T> t;
+    t.rows = m.cols;
+    t.cols = m.rows;
+    t.offsets.assign(m.cols + 1, 0);
+    for (int j : m.indices)
+        t.offsets[j + 1]++;
+    for (int j = 0; j < m.cols; j++)
+        t.offsets[j + 1] += t.offsets[j];
+    t.indices.resize(m.indices.size());
+    t.values.resize(m.values.size());
+    vector<int> fill(t.offsets.begin(), t.offsets.end() - 1);
+    for (int i = 0; i < m.rows; i++) {
+        for (int k = m.offsets[i]; k < m.offsets[i + 1]; k++) {
+            int pos = fill[m.indices[k]]++;
+            t.indices[pos] = i;
+            t.values[pos] = m.values[k];
+        }
+    }
+    return t;
+}
+
+// Returns the rows of m listed in row_ids, in that order.
+template <class T>
+CsrMatrix<T> selectRows(const CsrMatrix<T>& m, const vector<int>& row_ids) {
+    CsrMatrix<T> s;
+    s.rows = (int)row_ids.size();
+    s.cols = m.cols;
+    for (int i : row_ids) {
+        s.indices.insert(s.indices.end(), m.rowIndices(i),
+                         m.rowIndices(i) + m.rowSize(i));
+        s.values.insert(s.values.end(), m.rowValues(i),
+                        m.rowValues(i) + m.rowSize(i));
+        s.offsets.push_back((int)s.indices.size());
+    }
+    return s;
+}
+
+// n by n identity pattern, usable as a complemented mask to drop diagonals.
+inline CsrMatrix<char> identityMatrix(int n) {
+    CsrMatrix<char> m;
+    m.rows = m.cols = n;
+    m.offsets.resize(n + 1);
+    m.indices.resize(n);
+    m.values.assign(n, 1);
+    for (int i = 0; i < n; i++) {
+        m.offsets[i + 1] = i + 1;
+        m.indices[i] = i;
+    }
+    return m;
+}
+
+
+/*
+ * Dense sparse-matrix vector product y = A x. Rows where row_mask is 0 are
+ * skipped and left as zero(); an empty row_mask computes every row.
+ *
+ * Parameters:
+ *  a -
+ *      Matrix to multiply.
+ *  x -
+ *      Dense vector of a.cols entries.
+ *  row_mask -
+ *      Optional flags of the rows to compute.
+ *
+ * Returns:
+ *  vector -
+ *      Dense vector of a.rows entries.
+ */
+template <class Semiring, class T, class X>
+vector<typename Semiring::value_type> spmv(
+        const CsrMatrix<T>& a, const vector<X>& x,
+        const vector<char>& row_mask = vector<char>()) {
+    typedef typename Semiring::value_type V;
+    vector<V> y(a.rows, Semiring::zero());
+    parallelFor(0, a.rows, 1024, [&](int lo, int hi, int) {
+        for (int i = lo; i < hi; i++) {
+            if (!row_mask.empty() && !row_mask[i])
+                continue;
+            V sum = Semiring::zero();
+            const int* cols = a.rowIndices(i);
+            const T* vals = a.rowValues(i);
+            int n = a.rowSize(i);
+            for (int k = 0; k < n; k++)
+                sum = Semiring::add(sum, Semiring::mul(vals[k], x[cols[k]]));
+            y[i] = sum;
+        }
+    });
+    return y;
+}
+
+
+/*
+ * Sparse-matrix sparse-vector product y = A x, visiting only the columns of
+ * A where x has entries. Takes A in CSC form, i.e. the CSR form of A
+ * transposed, so for a symmetric A the CSR matrix itself may be passed.
+ *
+ * Parameters:
+ *  a_csc -
+ *      Matrix to multiply, in CSC form.
+ *  x -
+ *      Sparse vector of a.cols entries.
+ *  mask -
+ *      Optional flags of the entries of y to keep, or drop if complement.
+ *  complement -
+ *      Whether mask lists entries to drop rather than keep.
+ */
+template <class Semiring, class T, class X>
+SparseVector<typename Semiring::value_type> spmspv(
+        const CscMatrix<T>& a_csc, const SparseVector<X>& x,
+        const vector<char>& mask = vector<char>(), bool complement = false) {
+    typedef typename Semiring::value_type V;
+    int n = a_csc.cols;
+    vector<V> acc(n, Semiring::zero());
+    vector<char> seen(n, 0);
+    SparseVector<V> y;
+    y.size = n;
+
+    for (size_t e = 0; e < x.indices.size(); e++) {
+        int j = x.indices[e];
+        const int* rows = a_csc.rowIndices(j);
+        const T* vals = a_csc.rowValues(j);
+        int len = a_csc.rowSize(j);
+        for (int k = 0; k < len; k++) {
+            int i = rows[k];
+            if (!mask.empty() && (mask[i] != 0) == complement)
+                continue;
+            if (!seen[i]) {
+                seen[i] = 1;
+                y.indices.push_back(i);
+            }
+            acc[i] = Semiring::add(acc[i], Semiring::mul(vals[k],
+                                                         x.values[e]));
+        }
+    }
+    sort(y.indices.begin(), y.indices.end());
+    y.values.reserve(y.indices.size());
+    for (int i : y.indices)
+        y.values.push_back(acc[i]);
+    return y;
+}
+
+
+/*
+ * Breadth first search as a sequence of sparse products: each level is the
+ * previous level times A over OrAnd, masked to drop the rows reached
+ * already, so only the columns of the frontier are visited.
+ *
+ * Parameters:
+ *  a_csc -
+ *      Square matrix of the graph, in CSC form, as for spmspv.
+ *  source -
+ *      Row to search from.
+ *
+ * Return:
+ *  vector -
+ *      Hops of each row from source, -1 if not reached.
+ */
+template <class T>
+vector<int> bfsLevels(const CscMatrix<T>& a_csc, int source) {
+    vector<int> levels(a_csc.cols, -1);
+    vector<char> reached(a_csc.cols, 0);
+    SparseVector<char> frontier;
+    frontier.size = a_csc.cols;
+    frontier.indices.push_back(source);
+    frontier.values.push_back(1);
+    for (int hops = 0; !frontier.indices.empty(); hops++) {
+        for (int v : frontier.indices) {
+            levels[v] = hops;
+            reached[v] = 1;
+        }
+        frontier = spmspv<OrAnd>(a_csc, frontier, reached, true);
+    }
+    return levels;
+}
+
+
+/*
+ * Masked sparse-matrix sparse-matrix product C = A B, keeping only entries
+ * present in the mask, or absent from it if complement is set. Rows of C are
+ * computed independently with Gustavson's algorithm, in parallel.
+ *
+ * Parameters:
+ *  a -
+ *      Left matrix, a.cols == b.rows.
+ *  b -
+ *      Right matrix.
+ *  mask -
+ *      Pattern of mask.rows == a.rows rows and b.cols columns. Values are
+ *      ignored.
+ *  complement -
+ *      Whether the mask lists entries to drop rather than keep.
+ *  col_filter -
+ *      Optional flags of the columns of C which may hold entries, applied to
+ *      every row on top of the mask.
+ */
+template <class Semiring, class TA, class TB, class TM>
+CsrMatrix<typename Semiring::value_type> maskedSpgemm(
+        const CsrMatrix<TA>& a, const CsrMatrix<TB>& b,
+        const CsrMatrix<TM>& mask, bool complement,
+        const vector<char>& col_filter = vector<char>()) {
+    typedef typename Semiring::value_type V;
+    int threads = numThreads();
+    int n = b.cols;
+
+    // State of each column outside the mask: 1 kept, 2 dropped
+    vector<char> outside(n, complement ? 1 : 2);
+    for (int j = 0; j < (int)col_filter.size(); j++) {
+        if (!col_filter[j])
+            outside[j] = 2;
+    }
+
+    // Per thread dense accumulators, and the rows each produced
+    vector<vector<V>> acc(threads);
+    vector<vector<char>> state(threads);
+    vector<vector<int>> row_indices(a.rows);
+    vector<vector<V>> row_values(a.rows);
+
+    parallelFor(0, a.rows, 64, [&](int lo, int hi, int t) {
+        // state: 1 kept, 2 dropped, 3 holds an accumulated value
+        if (acc[t].empty()) {
+            acc[t].assign(n, Semiring::zero());
+            state[t] = outside;
+        }
+        vector<V>& sums = acc[t];
+        vector<char>& flag = state[t];
+        vector<int> cols;
+        for (int i = lo; i < hi; i++) {
+            const int* m_cols = mask.rowIndices(i);
+            int m_len = mask.rowSize(i);
+            for (int k = 0; k < m_len; k++) {
+                if (col_filter.empty() || col_filter[m_cols[k]])
+                    flag[m_cols[k]] = complement ? 2 : 1;
+            }
+
+            cols.clear();
+            const int* a_cols = a.rowIndices(i);
+            const TA* a_vals = a.rowValues(i);
+            int a_len = a.rowSize(i);
+            for (int ka = 0; ka < a_len; ka++) {
+                int k = a_cols[ka];
+                const int* b_cols = b.rowIndices(k);
+                const TB* b_vals = b.rowValues(k);
+                int b_len = b.rowSize(k);
+                for (int kb = 0; kb < b_len; kb++) {
+                    int j = b_cols[kb];
+                    if (flag[j] == 2)
+                        continue;
+                    if (flag[j] != 3) {
+                        flag[j] = 3;
+                        cols.push_back(j);
+                    }
+                    sums[j] = Semiring::add(sums[j],
+                                            Semiring::mul(a_vals[ka],
+                                                          b_vals[kb]));
+                }
+            }
+
+            sort(cols.begin(), cols.end());
+            row_indices[i] = cols;
+            row_values[i].reserve(cols.size());
+            for (int j : cols) {
+                row_values[i].push_back(sums[j]);
+                sums[j] = Semiring::zero();
+                flag[j] = outside[j];
+            }
+            for (int k = 0; k < m_len; k++)
+                flag[m_cols[k]] = outside[m_cols[k]];
+        }
+    });
+
+    // Concatenate the rows
+    CsrMatrix<V> c;
+    c.rows = a.rows;
+    c.cols = n;
+    c.offsets.assign(a.rows + 1, 0);
+    for (int i = 0; i < a.rows; i++)
+        c.offsets[i + 1] = c.offsets[i] + (int)row_indices[i].size();
+    c.indices.resize(c.offsets[a.rows]);
+    c.values.resize(c.offsets[a.rows]);
+    parallelFor(0, a.rows, 1024, [&](int lo, int hi, int) {
+        for (int i = lo; i < hi; i++) {
+            copy(row_indices[i].begin(), row_indices[i].end(),
+                 c.indices.begin() + c.offsets[i]);
+            copy(row_values[i].begin(), row_values[i].end(),
+                 c.values.begin() + c.offsets[i]);
+            vector<int>().swap(row_indices[i]);
+            vector<V>().swap(row_values[i]);
+        }
+    });
+    return c;
+}
+
+#endif  // SPARSEMATRIX_HPP
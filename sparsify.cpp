@@ -0,0 +1,188 @@
+/*
+ * This file implements the sparsifiers of the actor graph. See sparsify.hpp.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "actorgraph.hpp"
+#include "sparsify.hpp"
+#include "trace.hpp"
+
+using namespace std;
+
+
+/*
+ * Keeps a uniform sample of cap roles of every movie with a larger cast.
+ *
+ * Parameters:
+ *  graph -
+ *      Loaded graph.
+ *  cap -
+ *      Largest cast kept.
+ *  random -
+ *      Source of the samples.
+ *  keep -
+ *      Flags of the roles kept, by role id.
+ */
+static void SampleCasts(const ActorGraph& graph, int cap, mt19937& random,
+                        vector<char>& keep) {
+    // Roles of every movie
+    int num_movies = graph.numMovies();
+    vector<vector<int>> cast_roles(num_movies);
+    for (int a = 0; a < graph.numActors(); a++) {
+        int role = graph.firstRole(a);
+        for (int m : graph.moviesOf(a))
+            cast_roles[m].push_back(role++);
+    }
+    for (int m = 0; m < num_movies; m++) {
+        vector<int>& roles = cast_roles[m];
+        int kept = min(max(cap, 0), (int)roles.size());
+        // Partial Fisher-Yates shuffle of the first kept roles
+        for (int i = 0; i < kept; i++) {
+            int j = i + (int)(random() % (unsigned)(roles.size() - i));
+            swap(roles[i], roles[j]);
+            keep[roles[i]] = 1;
+        }
+    }
+}
+
+
+/*
+ * Keeps every role with probability min(1, q R), R its estimated effective
+ * resistance, with q found by bisection so the expected roles kept are the
+ * share asked for.
+ *
+ * Parameters:
+ *  graph -
+ *      Loaded graph.
+ *  share -
+ *      Expected share of the roles kept.
+ *  random -
+ *      Source of the samples.
+ *  keep -
+ *      Flags of the roles kept, by role id.
+ */
+static void SampleResistances(const ActorGraph& graph, double share,
+                              mt19937& random, vector<char>& keep) {
+    vector<double> resistance(graph.numRoles());
+    for (int a = 0; a < graph.numActors(); a++) {
+        int role = graph.firstRole(a);
+        double actor_part = 1.0 / graph.moviesOf(a).size();
+        for (int m : graph.moviesOf(a))
+            resistance[role++] = actor_part + 1.0 / graph.castOf(m).size();
+    }
+    double target = min(max(share, 0.0), 1.0) * graph.numRoles();
+    auto expected = [&](double q) {
+        double sum = 0;
+        for (double r : resistance)
+            sum += min(1.0, q * r);
+        return sum;
+    };
+    // Every resistance is over 0, and at most 2, so q = n keeps every role
+    double lo = 0, hi = max(1, graph.numRoles());
+    for (int step = 0; step < 60; step++) {
+        double mid = (lo + hi) / 2;
+        (expected(mid) < target ? lo : hi) = mid;
+    }
+    uniform_real_distribution<double> uniform(0, 1);
+    for (int r = 0; r < graph.numRoles(); r++)
+        keep[r] = uniform(random) < min(1.0, hi * resistance[r]);
+}
+
+
+/*
+ * Keeps, for every actor and movie of degree d, the roles linking it to its
+ * ceil(d^e) neighbors of highest degree, ties to the lowest id.
+ *
+ * Parameters:
+ *  graph -
+ *      Loaded graph.
+ *  exponent -
+ *      Exponent e, in (0, 1].
+ *  keep -
+ *      Flags of the roles kept, by role id.
+ */
+static void FilterLocalDegree(const ActorGraph& graph, double exponent,
+                              vector<char>& keep) {
+    auto kept = [&](int degree) {
+        return min(degree, (int)ceil(pow((double)degree, exponent)));
+    };
+
+    // Actors keep their largest movies
+    vector<int> order;
+    int num_movies = graph.numMovies();
+    vector<vector<int>> cast_roles(num_movies);
+    for (int a = 0; a < graph.numActors(); a++) {
+        IdRange movies = graph.moviesOf(a);
+        int first = graph.firstRole(a);
+        order.resize(movies.size());
+        for (int i = 0; i < movies.size(); i++) {
+            order[i] = i;
+            cast_roles[movies.begin()[i]].push_back(first + i);
+        }
+        int n = kept(movies.size());
+        partial_sort(order.begin(), order.begin() + n, order.end(),
+                     [&](int x, int y) {
+            int mx = movies.begin()[x], my = movies.begin()[y];
+            int cx = graph.castOf(mx).size(), cy = graph.castOf(my).size();
+            return cx != cy ? cx > cy : mx < my;
+        });
+        for (int i = 0; i < n; i++)
+            keep[first + order[i]] = 1;
+    }
+
+    // Movies keep their most prolific actors, found from the role ids
+    vector<int> role_actor(graph.numRoles());
+    for (int a = 0; a < graph.numActors(); a++) {
+        int end = graph.firstRole(a) + graph.moviesOf(a).size();
+        for (int r = graph.firstRole(a); r < end; r++)
+            role_actor[r] = a;
+    }
+    for (int m = 0; m < num_movies; m++) {
+        vector<int>& roles = cast_roles[m];
+        int n = kept(roles.size());
+        partial_sort(roles.begin(), roles.begin() + n, roles.end(),
+                     [&](int x, int y) {
+            int ax = role_actor[x], ay = role_actor[y];
+            int dx = graph.moviesOf(ax).size(), dy = graph.moviesOf(ay).size();
+            return dx != dy ? dx > dy : ax < ay;
+        });
+        for (int i = 0; i < n; i++)
+            keep[roles[i]] = 1;
+    }
+}
+
+
+/*
+ * Chooses the roles of a sparsified graph.
+ *
+ * Parameters:
+ *  graph -
+ *      Loaded graph.
+ *  method -
+ *      How roles are chosen.
+ *  amount -
+ *      Cap on the cast for CAST_SAMPLING, share of roles kept for
+ *      RESISTANCE_SAMPLING, exponent e in (0, 1] for LOCAL_DEGREE.
+ *  seed -
+ *      Seed of the random choices.
+ *
+ * Returns:
+ *  vector -
+ *      1 for each role kept, by role id (see ActorGraph firstRole).
+ */
+vector<char> sparsifyRoles(const ActorGraph& graph, SparsifyMethod method,
+                           double amount, unsigned seed) {
+    TRACE_SCOPE("sparsify");
+    vector<char> keep(graph.numRoles(), 0);
+    mt19937 random(seed);
+    if (method == CAST_SAMPLING)
+        SampleCasts(graph, (int)amount, random, keep);
+    else if (method == RESISTANCE_SAMPLING)
+        SampleResistances(graph, amount, random, keep);
+    else
+        FilterLocalDegree(graph, amount, keep);
+    return keep;
+}
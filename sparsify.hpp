@@ -0,0 +1,67 @@
+/*
+ * This file declares the sparsifiers of the actor graph, which keep a subset
+ * of the roles so analyses run on a much smaller snapshot with approximate
+ * results. Roles rather than co-star links are dropped, so a sparsified
+ * graph is written as a data.tsv any program reads, and its co-star links
+ * are those of the roles kept: a cast of c actors cut to k drops c(c - 1) / 2
+ * - k(k - 1) / 2 links of the projection.
+ *
+ *  CAST_SAMPLING       - every movie with a cast over a cap keeps a uniform
+ *                        sample of cap of its cast.
+ *  RESISTANCE_SAMPLING - every role is kept with probability proportional
+ *                        to its effective resistance, scaled so the expected
+ *                        share of roles kept is the amount (Spielman and
+ *                        Srivastava, "Graph Sparsification by Effective
+ *                        Resistances", 2008). The resistance between an
+ *                        actor of degree d and a movie with a cast of c is
+ *                        estimated locally as 1/d + 1/c, which ignores the
+ *                        rest of the graph: on a path a - m - b it gives 1.5
+ *                        where the resistance is 1. Roles of actors of a
+ *                        single movie estimate 1 + 1/c, the most, and are
+ *                        kept for sure only when q >= 1 / (1 + 1/c), q the
+ *                        scale of the probabilities.
+ *  LOCAL_DEGREE        - every actor and movie of degree d keeps its roles
+ *                        with the ceil(d^e) neighbors of highest degree, and
+ *                        a role is kept if either end keeps it (Hamann et
+ *                        al., "Structure-Preserving Sparsification of Social
+ *                        Networks", 2016). Every actor and movie keeps at
+ *                        least one role, and hubs keep the backbone.
+ *
+ * Kept roles are not reweighted: data.tsv has no weights, so resistance
+ * sampling preserves the structure of the graph rather than its spectrum
+ * exactly.
+ */
+
+#ifndef SPARSIFY_HPP
+#define SPARSIFY_HPP
+
+#include <vector>
+#include "actorgraph.hpp"
+
+using namespace std;
+
+// Ways of choosing the roles kept.
+enum SparsifyMethod { CAST_SAMPLING, RESISTANCE_SAMPLING, LOCAL_DEGREE };
+
+/*
+ * Chooses the roles of a sparsified graph.
+ *
+ * Parameters:
+ *  graph -
+ *      Loaded graph.
+ *  method -
+ *      How roles are chosen.
+ *  amount -
+ *      Cap on the cast for CAST_SAMPLING, share of roles kept for
+ *      RESISTANCE_SAMPLING, exponent e in (0, 1] for LOCAL_DEGREE.
+ *  seed -
+ *      Seed of the random choices.
+ *
+ * Returns:
+ *  vector -
+ *      1 for each role kept, by role id (see ActorGraph firstRole).
+ */
+vector<char> sparsifyRoles(const ActorGraph& graph, SparsifyMethod method,
+                           double amount, unsigned seed = 1);
+
+#endif  // SPARSIFY_HPP
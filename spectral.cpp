@@ -0,0 +1,320 @@
+/*
+ * This file implements the Lanczos eigensolver and the spectral kernels of
+ * the co-star graph. See spectral.hpp.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "sparsematrix.hpp"
+#include "spectral.hpp"
+#include "trace.hpp"
+
+using namespace std;
+
+// Steps past twice the pairs wanted of the first Lanczos basis
+const static int EXTRA_STEPS = 40;
+
+
+// Dot product of two vectors of the same size.
+static double Dot(const vector<double>& x, const vector<double>& y) {
+    double sum = 0;
+    for (size_t i = 0; i < x.size(); i++)
+        sum += x[i] * y[i];
+    return sum;
+}
+
+// Adds a times x to y.
+static void Axpy(double a, const vector<double>& x, vector<double>& y) {
+    for (size_t i = 0; i < x.size(); i++)
+        y[i] += a * x[i];
+}
+
+
+/*
+ * Finds the eigenpairs of a symmetric tridiagonal matrix by the implicit QL
+ * method with shifts (tql2 of EISPACK, as in JAMA).
+ *
+ * Parameters:
+ *  d -
+ *      Diagonal of the k by k matrix, replaced by its eigenvalues in
+ *      increasing order.
+ *  e -
+ *      Subdiagonal, e[i] joining rows i - 1 and i, e[0] unused. Destroyed.
+ *  z -
+ *      Receives the eigenvectors as the columns of a k by k row major
+ *      matrix, in the order of d.
+ */
+static void TridiagonalEigen(vector<double>& d, vector<double>& e,
+                             vector<double>& z) {
+    int k = (int)d.size();
+    z.assign((size_t)k * k, 0);
+    for (int i = 0; i < k; i++)
+        z[(size_t)i * k + i] = 1;
+    for (int i = 1; i < k; i++)
+        e[i - 1] = e[i];
+    if (k > 0)
+        e[k - 1] = 0;
+
+    double f = 0, largest = 0;
+    const double eps = ldexp(1.0, -52);
+    for (int l = 0; l < k; l++) {
+        // Find a negligible subdiagonal element to split at
+        largest = max(largest, fabs(d[l]) + fabs(e[l]));
+        int m = l;
+        while (m < k && fabs(e[m]) > eps * largest)
+            m++;
+        if (m > l) {
+            do {
+                // Shift by the eigenvalue of the leading 2 by 2 block
+                double g = d[l];
+                double p = (d[l + 1] - g) / (2 * e[l]);
+                double r = hypot(p, 1.0);
+                if (p < 0)
+                    r = -r;
+                d[l] = e[l] / (p + r);
+                d[l + 1] = e[l] * (p + r);
+                double dl1 = d[l + 1];
+                double h = g - d[l];
+                for (int i = l + 2; i < k; i++)
+                    d[i] -= h;
+                f += h;
+
+                // Chase the bulge with plane rotations
+                p = d[m];
+                double c = 1, c2 = 1, c3 = 1, s = 0, s2 = 0;
+                double el1 = e[l + 1];
+                for (int i = m - 1; i >= l; i--) {
+                    c3 = c2;
+                    c2 = c;
+                    s2 = s;
+                    g = c * e[i];
+                    h = c * p;
+                    r = hypot(p, e[i]);
+                    e[i + 1] = s * r;
+                    s = e[i] / r;
+                    c = p / r;
+                    p = c * d[i] - s * g;
+                    d[i + 1] = h + s * (c * g + s * d[i]);
+                    for (int row = 0; row < k; row++) {
+                        double* zr = &z[(size_t)row * k];
+                        h = zr[i + 1];
+                        zr[i + 1] = s * zr[i] + c * h;
+                        zr[i] = c * zr[i] - s * h;
+                    }
+                }
+                p = -s * s2 * c3 * el1 * e[l] / dl1;
+                e[l] = s * p;
+                d[l] = c * p;
+            } while (fabs(e[l]) > eps * largest);
+        }
+        d[l] += f;
+        e[l] = 0;
+    }
+
+    // Sort the eigenvalues and vectors in increasing order
+    for (int i = 0; i < k - 1; i++) {
+        int least = (int)(min_element(d.begin() + i, d.end()) - d.begin());
+        if (least == i)
+            continue;
+        swap(d[i], d[least]);
+        for (int row = 0; row < k; row++)
+            swap(z[(size_t)row * k + i], z[(size_t)row * k + least]);
+    }
+}
+
+
+/*
+ * Finds the largest eigenpairs of a symmetric matrix by Lanczos iteration
+ * with full reorthogonalization. The basis grows until every wanted Ritz
+ * pair has a residual, the last subdiagonal element times the last entry of
+ * its tridiagonal eigenvector, under the tolerance. Eigenvectors are signed
+ * so their entry largest in magnitude is positive.
+ *
+ * Parameters:
+ *  n -
+ *      Size of the matrix.
+ *  multiply -
+ *      Product of the matrix with a vector.
+ *  wanted -
+ *      Number of eigenpairs wanted, at most n.
+ *  tolerance -
+ *      Largest residual |A y - theta y| of a pair, relative to the largest
+ *      eigenvalue in magnitude.
+ *  seed -
+ *      Seed of the random start vector.
+ *
+ * Returns:
+ *  Eigenpairs -
+ *      The wanted eigenpairs, fewer if the matrix has fewer.
+ */
+Eigenpairs lanczos(int n, const Operator& multiply, int wanted,
+                   double tolerance, unsigned seed) {
+    TRACE_SCOPE("lanczos");
+    Eigenpairs result;
+    wanted = min(wanted, n);
+    if (wanted <= 0)
+        return result;
+
+    // Orthonormal basis, and the diagonal and subdiagonal of the matrix in it
+    vector<vector<double>> basis(1, vector<double>(n));
+    vector<double> alpha, beta;
+    mt19937 random(seed);
+    uniform_real_distribution<double> uniform(-1, 1);
+    for (double& x : basis[0])
+        x = uniform(random);
+    double norm = sqrt(Dot(basis[0], basis[0]));
+    for (double& x : basis[0])
+        x /= norm;
+
+    int limit = min(n, 2 * wanted + EXTRA_STEPS);
+    bool invariant = false;
+    double scale = 0;
+    vector<double> w(n), d, e, z;
+    for (;;) {
+        while ((int)alpha.size() < limit && !invariant) {
+            int j = (int)alpha.size();
+            multiply(basis[j], w);
+            double a = Dot(w, basis[j]);
+            // Twice is enough to orthogonalize in floating point
+            for (int pass = 0; pass < 2; pass++) {
+                for (int i = 0; i <= j; i++)
+                    Axpy(-Dot(w, basis[i]), basis[i], w);
+            }
+            double b = sqrt(Dot(w, w));
+            alpha.push_back(a);
+            beta.push_back(b);
+            scale = max(scale, fabs(a) + b);
+            if (b <= 1e-12 * scale || j + 1 == n) {
+                invariant = true;
+                break;
+            }
+            for (double& x : w)
+                x /= b;
+            basis.push_back(w);
+        }
+
+        // Ritz pairs of the basis so far, the wanted ones last
+        int k = (int)alpha.size();
+        d = alpha;
+        e.assign(k, 0);
+        for (int i = 1; i < k; i++)
+            e[i] = beta[i - 1];
+        TridiagonalEigen(d, e, z);
+        int found = min(wanted, k);
+        double largest = max(fabs(d[0]), fabs(d[k - 1]));
+        bool converged = true;
+        for (int i = k - found; i < k && !invariant; i++) {
+            double residual = beta[k - 1] * fabs(z[(size_t)(k - 1) * k + i]);
+            converged = converged && residual <= tolerance * largest;
+        }
+        if (converged || invariant || k == n) {
+            result.steps = k;
+            result.converged = converged || invariant;
+            for (int i = k - 1; i >= k - found; i--) {
+                vector<double> y(n, 0);
+                for (int j = 0; j < k; j++)
+                    Axpy(z[(size_t)j * k + i], basis[j], y);
+                double top = 0;
+                for (double x : y)
+                    top = fabs(x) > fabs(top) ? x : top;
+                if (top < 0) {
+                    for (double& x : y)
+                        x = -x;
+                }
+                result.values.push_back(d[i]);
+                result.vectors.push_back(y);
+            }
+            return result;
+        }
+        limit = min(n, 2 * limit);
+    }
+}
+
+
+/*
+ * Embeds every actor in dims dimensions from the eigenvectors of the
+ * normalized adjacency D^-1/2 A D^-1/2, whose product with x is a product
+ * of A with x scaled by D^-1/2, scaled once more.
+ *
+ * Parameters:
+ *  adjacency -
+ *      Symmetric co-star matrix.
+ *  dims -
+ *      Dimensions of the embedding.
+ *  eigenvalues -
+ *      Receives the eigenvalues of u_0 to u_dims, fewer if the Lanczos
+ *      basis spans fewer.
+ *  converged -
+ *      Receives whether every eigenpair met the Lanczos tolerance.
+ *
+ * Returns:
+ *  vector -
+ *      Coordinates of actor v at [v * dims, (v + 1) * dims).
+ */
+vector<double> spectralEmbedding(const CsrMatrix<char>& adjacency, int dims,
+                                 vector<double>& eigenvalues,
+                                 bool& converged) {
+    TRACE_SCOPE("spectral embedding");
+    int n = adjacency.rows;
+    vector<double> scale(n);
+    for (int v = 0; v < n; v++) {
+        int degree = adjacency.rowSize(v);
+        scale[v] = degree ? 1 / sqrt((double)degree) : 0;
+    }
+    vector<double> scaled(n);
+    Operator normalized = [&](const vector<double>& x, vector<double>& y) {
+        for (int v = 0; v < n; v++)
+            scaled[v] = x[v] * scale[v];
+        y = spmv<PlusTimes<double>>(adjacency, scaled);
+        for (int v = 0; v < n; v++)
+            y[v] *= scale[v];
+    };
+    Eigenpairs pairs = lanczos(n, normalized, dims + 1);
+    eigenvalues = pairs.values;
+    converged = pairs.converged;
+
+    vector<double> coordinates((size_t)n * dims, 0);
+    for (int i = 1; i < (int)pairs.vectors.size(); i++) {
+        const vector<double>& u = pairs.vectors[i];
+        for (int v = 0; v < n; v++)
+            coordinates[(size_t)v * dims + i - 1] = u[v] * scale[v];
+    }
+    return coordinates;
+}
+
+
+/*
+ * Finds the eigenvector centrality of every actor as the eigenvector of the
+ * largest eigenvalue of the adjacency, scaled to a largest value of 1.
+ * Entries left slightly negative by rounding are taken as 0.
+ *
+ * Parameters:
+ *  adjacency -
+ *      Symmetric co-star matrix.
+ *  eigenvalue -
+ *      Receives the largest eigenvalue of the adjacency.
+ *
+ * Returns:
+ *  vector -
+ *      Centrality of every actor.
+ */
+vector<double> eigenvectorCentrality(const CsrMatrix<char>& adjacency,
+                                     double& eigenvalue) {
+    TRACE_SCOPE("eigenvector centrality");
+    int n = adjacency.rows;
+    Operator product = [&](const vector<double>& x, vector<double>& y) {
+        y = spmv<PlusTimes<double>>(adjacency, x);
+    };
+    Eigenpairs pairs = lanczos(n, product, 1);
+    eigenvalue = pairs.values.empty() ? 0 : pairs.values[0];
+    vector<double> centrality(n, 0);
+    if (pairs.vectors.empty())
+        return centrality;
+    double top = *max_element(pairs.vectors[0].begin(),
+                              pairs.vectors[0].end());
+    for (int v = 0; v < n; v++)
+        centrality[v] = top > 0 ? max(pairs.vectors[0][v], 0.0) / top : 0;
+    return centrality;
+}
@@ -0,0 +1,114 @@
+/*
+ * This file declares the spectral kernels over the co-star graph: a Lanczos
+ * eigensolver for symmetric matrices given by their product with a vector,
+ * and on it a spectral embedding of the actors and their eigenvector
+ * centrality, computed in memory linear in the connections.
+ *
+ *  lanczos                - the largest eigenpairs of a symmetric matrix.
+ *  spectralEmbedding      - coordinates of every actor in d dimensions from
+ *                           the eigenvectors of the normalized adjacency
+ *                           D^-1/2 A D^-1/2 after the first, as in Laplacian
+ *                           eigenmaps (Belkin and Niyogi, 2003), so actors
+ *                           who share co-stars lie close together.
+ *  eigenvectorCentrality  - the eigenvector of the largest eigenvalue of the
+ *                           adjacency A: an actor is central if its co-stars
+ *                           are.
+ *
+ * Lanczos builds an orthonormal basis of the Krylov space of a random vector
+ * one product at a time, in which the matrix is tridiagonal, and takes the
+ * eigenpairs of the tridiagonal matrix (Ritz pairs) as those of the matrix.
+ * Each new basis vector is orthogonalized against all before it, so no
+ * eigenvalue is found twice. The basis grows until every wanted Ritz pair
+ * has a residual under the tolerance, doubling from twice the pairs wanted
+ * plus 40 vectors, and takes a vector per step besides the matrix. Products
+ * are spmv over the CSR matrix, spread over numThreads() threads.
+ */
+
+#ifndef SPECTRAL_HPP
+#define SPECTRAL_HPP
+
+#include <functional>
+#include <vector>
+#include "sparsematrix.hpp"
+
+using namespace std;
+
+// Largest eigenvalues of a matrix, decreasing, and their unit eigenvectors.
+struct Eigenpairs {
+    vector<double> values;
+    vector<vector<double>> vectors;
+    // Lanczos steps taken, and whether every pair met the tolerance
+    int steps = 0;
+    bool converged = false;
+};
+
+// Product of a symmetric matrix with x, into y of the same size.
+typedef function<void(const vector<double>& x, vector<double>& y)> Operator;
+
+/*
+ * Finds the largest eigenpairs of a symmetric matrix by Lanczos iteration
+ * with full reorthogonalization.
+ *
+ * Parameters:
+ *  n -
+ *      Size of the matrix.
+ *  multiply -
+ *      Product of the matrix with a vector.
+ *  wanted -
+ *      Number of eigenpairs wanted, at most n.
+ *  tolerance -
+ *      Largest residual |A y - theta y| of a pair, relative to the largest
+ *      eigenvalue in magnitude.
+ *  seed -
+ *      Seed of the random start vector.
+ *
+ * Returns:
+ *  Eigenpairs -
+ *      The wanted eigenpairs, fewer if the matrix has fewer.
+ */
+Eigenpairs lanczos(int n, const Operator& multiply, int wanted,
+                   double tolerance = 1e-8, unsigned seed = 1);
+
+/*
+ * Embeds every actor in dims dimensions: coordinate i of actor v is
+ * u_i(v) / sqrt(degree of v), for the eigenvectors u_1, u_2, ... of the
+ * normalized adjacency in decreasing order of eigenvalue, skipping u_0.
+ * Actors without co-stars sit at the origin.
+ *
+ * Parameters:
+ *  adjacency -
+ *      Symmetric co-star matrix.
+ *  dims -
+ *      Dimensions of the embedding.
+ *  eigenvalues -
+ *      Receives the eigenvalues of u_0 to u_dims, fewer if the Lanczos
+ *      basis spans fewer.
+ *  converged -
+ *      Receives whether every eigenpair met the Lanczos tolerance.
+ *
+ * Returns:
+ *  vector -
+ *      Coordinates of actor v at [v * dims, (v + 1) * dims).
+ */
+vector<double> spectralEmbedding(const CsrMatrix<char>& adjacency, int dims,
+                                 vector<double>& eigenvalues,
+                                 bool& converged);
+
+/*
+ * Finds the eigenvector centrality of every actor, scaled to a largest
+ * value of 1.
+ *
+ * Parameters:
+ *  adjacency -
+ *      Symmetric co-star matrix.
+ *  eigenvalue -
+ *      Receives the largest eigenvalue of the adjacency.
+ *
+ * Returns:
+ *  vector -
+ *      Centrality of every actor.
+ */
+vector<double> eigenvectorCentrality(const CsrMatrix<char>& adjacency,
+                                     double& eigenvalue);
+
+#endif  // SPECTRAL_HPP
@@ -0,0 +1,111 @@
+/*
+ * This file tests the streaming path pipeline (see pathpipeline.hpp). Use
+ *
+ * make test
+ *
+ * to build and run it from the top directory, which holds data/data.tsv.
+ */
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../actorgraph.hpp"
+#include "../parallel.hpp"
+#include "../pathpipeline.hpp"
+
+using namespace std;
+
+// Number of failed checks
+static int failures = 0;
+
+// Reports a failed check.
+static void Check(bool ok, const string& what) {
+    if (!ok) {
+        cout << "FAILED: " << what << endl;
+        failures++;
+    }
+}
+
+
+/*
+ * Streams a pairs file whose first batch is slow, group queries over many
+ * actors, and whose later batches are instant, empty rows. Workers race
+ * ahead of the head batch, yet the writer must never hold back as many
+ * batches as a queue holds, and must still write every row in order.
+ */
+static void TestSlowHeadBatch(const ActorGraph& graph) {
+    const int BATCH = 4;
+    const int QUEUE = 2;
+    const int EMPTY_ROWS = 20000;
+    string rows;
+    for (int r = 0; r < BATCH; r++) {
+        for (int i = 0; i < 16; i++) {
+            int actor = (r * 16 + i) * 97 % graph.numActors();
+            rows += (i ? "\t" : "") + graph.actorName(actor);
+        }
+        rows += '\n';
+    }
+    for (int r = 0; r < EMPTY_ROWS; r++)
+        rows += '\n';
+    istringstream pairs(rows);
+
+    PipelineOptions options;
+    options.mode = STEINER_QUERY;
+    options.batch = BATCH;
+    options.queue = QUEUE;
+    setNumThreads(4);
+    size_t written = 0;
+    bool ordered = true;
+    PipelineStats stats = streamPaths(graph, pairs, 0, options,
+                                      [&](const vector<string>& paths,
+                                          size_t done) {
+        ordered = ordered && done == written + paths.size();
+        // Only the head batch has answers
+        ordered = ordered && (written == 0) == !paths[0].empty();
+        written = done;
+    });
+    Check(written == (size_t)(BATCH + EMPTY_ROWS), "every row written");
+    Check(ordered, "rows written in order");
+    Check(stats.max_held < (size_t)QUEUE,
+          "writer held " + to_string(stats.max_held) + " batches, bound " +
+          to_string(QUEUE));
+}
+
+
+/*
+ * Names the bottleneck of hand made queue statistics: the stage the others
+ * waited on, the workers when the writer starved on few large batches while
+ * the reader never waited, and none when no stage waited.
+ */
+static void TestBottleneck() {
+    PipelineStats stats;
+    stats.workers = 4;
+    Check(pipelineBottleneck(stats) == "none", "no waits name no stage");
+    stats.output.pop_wait = 5.5;
+    Check(pipelineBottleneck(stats) == "search workers",
+          "a starved writer names the workers");
+    stats.input.pop_wait = 4 * 5.5;
+    Check(pipelineBottleneck(stats) == "reader",
+          "workers starved as long as the writer name the reader");
+    stats = PipelineStats();
+    stats.workers = 4;
+    stats.output.push_wait = 8;
+    stats.input.push_wait = 1;
+    Check(pipelineBottleneck(stats) == "writer",
+          "workers blocked on output name the writer");
+}
+
+
+int main() {
+    ActorGraph graph;
+    if (!graph.loadFromFile("data/data.tsv", false)) {
+        cout << "Failed to read data/data.tsv" << endl;
+        return 1;
+    }
+    TestSlowHeadBatch(graph);
+    TestBottleneck();
+    cout << (failures ? "pathpipelinetest failed" : "pathpipelinetest passed")
+         << endl;
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,115 @@
+/*
+ * This file tests the sparse products of sparsematrix.hpp against the
+ * traversal core and the dense product. Use
+ *
+ * make test
+ *
+ * to build and run it from the top directory, which holds data/data.tsv.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../actorgraph.hpp"
+#include "../graphmatrix.hpp"
+#include "../sparsematrix.hpp"
+#include "../traversal.hpp"
+
+using namespace std;
+
+// Number of failed checks
+static int failures = 0;
+
+// Reports a failed check.
+static void Check(bool ok, const string& what) {
+    if (!ok) {
+        cout << "FAILED: " << what << endl;
+        failures++;
+    }
+}
+
+
+/*
+ * Searches from a spread of actors by bfsLevels over the co-star matrix and
+ * by the breadth first traversal over the graph, which must agree on the
+ * hops of every actor.
+ */
+static void TestBfsLevels(const ActorGraph& graph,
+                          const CsrMatrix<char>& costars) {
+    SearchState state(graph);
+    for (int i = 0; i < 8; i++) {
+        int source = (int)((long long)i * graph.numActors() / 8);
+        vector<int> levels = bfsLevels(costars, source);
+        state.reset();
+        FifoFrontier frontier(state);
+        addSource(state, frontier, source);
+        TraversalVisitor visitor;
+        traverse(graph, state, frontier, UnitWeight(), visitor);
+        vector<int> hops(graph.numActors(), -1);
+        for (int v : state.touched)
+            hops[v] = state.dist[v];
+        Check(levels == hops, "bfsLevels from actor " + to_string(source) +
+                              " matches the traversal");
+    }
+}
+
+
+/*
+ * Multiplies the co-star matrix by a sparse vector, once with spmspv and
+ * once with the dense spmv, over PlusTimes.
+ */
+static void TestSpmspvMatchesSpmv(const CsrMatrix<char>& costars) {
+    SparseVector<int> x;
+    x.size = costars.cols;
+    vector<int> dense(costars.cols, 0);
+    for (int j = 0; j < costars.cols; j += 37) {
+        x.indices.push_back(j);
+        x.values.push_back(j % 5 + 1);
+        dense[j] = j % 5 + 1;
+    }
+    SparseVector<int> y = spmspv<PlusTimes<int>>(costars, x);
+    vector<int> expected = spmv<PlusTimes<int>>(costars, dense);
+    vector<int> found(costars.rows, 0);
+    for (size_t e = 0; e < y.indices.size(); e++)
+        found[y.indices[e]] = y.values[e];
+    Check(found == expected, "spmspv matches spmv");
+}
+
+
+/*
+ * Relaxes the edges out of a source over MinPlus on a small weighted graph:
+ * 0 -2- 1 -3- 2, and 0 -9- 2. Two products from the source's distance give
+ * the shortest distances within two edges.
+ */
+static void TestMinPlusRelaxation() {
+    typedef pair<pair<int, int>, int> Entry;
+    CsrMatrix<int> a = fromTriples<MinPlus<int>, int>(3, 3, {
+        Entry({0, 1}, 2), Entry({1, 0}, 2), Entry({1, 2}, 3),
+        Entry({2, 1}, 3), Entry({0, 2}, 9), Entry({2, 0}, 9)});
+    SparseVector<int> dist;
+    dist.size = 3;
+    dist.indices = {0};
+    dist.values = {0};
+    SparseVector<int> one = spmspv<MinPlus<int>>(a, dist);
+    Check(one.indices == vector<int>({1, 2}) &&
+          one.values == vector<int>({2, 9}), "MinPlus relaxes one edge");
+    SparseVector<int> two = spmspv<MinPlus<int>>(a, one);
+    Check(two.indices == vector<int>({0, 1, 2}) &&
+          two.values == vector<int>({4, 12, 5}), "MinPlus relaxes two edges");
+}
+
+
+int main() {
+    ActorGraph graph;
+    if (!graph.loadFromFile("data/data.tsv", false)) {
+        cout << "Failed to read data/data.tsv" << endl;
+        return 1;
+    }
+    CsrMatrix<char> costars = coStarMatrix(graph);
+    TestBfsLevels(graph, costars);
+    TestSpmspvMatchesSpmv(costars);
+    TestMinPlusRelaxation();
+    cout << (failures ? "sparsematrixtest failed" : "sparsematrixtest passed")
+         << endl;
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,97 @@
+/*
+ * This file tests the frontiers of the traversal core (see traversal.hpp)
+ * against a plain Dijkstra search over the weighted graph. Use
+ *
+ * make test
+ *
+ * to build and run it from the top directory, which holds data/data.tsv.
+ */
+
+#include <climits>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <string>
+#include <vector>
+#include "../actorgraph.hpp"
+#include "../traversal.hpp"
+
+using namespace std;
+
+// Number of failed checks
+static int failures = 0;
+
+// Reports a failed check.
+static void Check(bool ok, const string& what) {
+    if (!ok) {
+        cout << "FAILED: " << what << endl;
+        failures++;
+    }
+}
+
+
+// Distances from source by Dijkstra over (distance, actor) pairs, -1 if
+// not reached.
+static vector<int> PlainDistances(const ActorGraph& graph, int source) {
+    vector<int> dist(graph.numActors(), INT_MAX);
+    priority_queue<pair<int, int>, vector<pair<int, int>>,
+                   greater<pair<int, int>>> queue;
+    dist[source] = 0;
+    queue.push(pair<int, int>(0, source));
+    while (!queue.empty()) {
+        pair<int, int> top = queue.top();
+        queue.pop();
+        if (top.first > dist[top.second])
+            continue;
+        for (int m : graph.moviesOf(top.second)) {
+            int next = top.first + graph.movieWeight(m);
+            for (int a : graph.castOf(m)) {
+                if (next < dist[a]) {
+                    dist[a] = next;
+                    queue.push(pair<int, int>(next, a));
+                }
+            }
+        }
+    }
+    for (int& d : dist)
+        d = d == INT_MAX ? -1 : d;
+    return dist;
+}
+
+
+/*
+ * Searches the weighted graph from a spread of actors with bucket frontiers
+ * of several widths, which must settle every actor at its distance.
+ */
+static void TestBucketFrontier(const ActorGraph& graph) {
+    SearchState state(graph);
+    for (int i = 0; i < 4; i++) {
+        int source = (int)((long long)i * graph.numActors() / 4);
+        vector<int> expected = PlainDistances(graph, source);
+        for (int width : {1, 4, 16}) {
+            state.reset();
+            BucketFrontier frontier(state, width);
+            addSource(state, frontier, source);
+            TraversalVisitor visitor;
+            traverse(graph, state, frontier, MovieWeight(), visitor);
+            vector<int> found(graph.numActors(), -1);
+            for (int v : state.touched)
+                found[v] = state.dist[v];
+            Check(found == expected, "buckets of width " + to_string(width) +
+                                     " from actor " + to_string(source));
+        }
+    }
+}
+
+
+int main() {
+    ActorGraph graph;
+    if (!graph.loadFromFile("data/data.tsv", true)) {
+        cout << "Failed to read data/data.tsv" << endl;
+        return 1;
+    }
+    TestBucketFrontier(graph);
+    cout << (failures ? "traversaltest failed" : "traversaltest passed")
+         << endl;
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,183 @@
+/*
+ * This file contains the timeline tracing of the programs, which records when
+ * each thread begins and ends the phases of a run: loading, parallel chunks,
+ * batches of the pipeline, queue stalls and output flushes. At exit the
+ * events are written as a Chrome trace (trace event format JSON), which
+ * chrome://tracing or ui.perfetto.dev show as a timeline per thread.
+ *
+ * Tracing is compiled in only with -DACTORGRAPH_TRACE (make TRACE=1);
+ * otherwise every macro expands to nothing. Traced, each event is a clock
+ * read and a store into a ring buffer owned by the recording thread, so no
+ * thread waits on another. A buffer keeps the last TRACE_CAPACITY events of
+ * its threads, dropping the oldest. Buffers of finished threads are reused
+ * by later ones, so a timeline row is a slot of the thread pool rather than
+ * one thread. Trace phases, not inner loops, to keep the cost negligible.
+ *
+ *  TRACE_SCOPE(name)          - traces the enclosing scope.
+ *  TRACE_BEGIN(name)          - begins a span on this thread.
+ *  TRACE_END(name)            - ends the span begun last on this thread.
+ *  TRACE_THREAD(name)         - names the timeline row of this thread.
+ *  TRACE_FILE(filename)       - writes the trace to filename at exit,
+ *                               "trace.json" if never called.
+ *
+ * Names must be string literals, which are stored by address.
+ */
+
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#ifdef ACTORGRAPH_TRACE
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Events kept per buffer, a power of two.
+const size_t TRACE_CAPACITY = 1 << 15;
+
+// A begin or end event: name, phase 'B' or 'E', and nanoseconds since start.
+struct TraceEvent {
+    const char* name;
+    char phase;
+    long long ns;
+};
+
+// Ring buffer of the events of one thread at a time.
+struct TraceBuffer {
+    int tid;
+    const char* name = nullptr;
+    // Events recorded, the newest at (head - 1) % TRACE_CAPACITY
+    atomic<size_t> head{0};
+    vector<TraceEvent> events;
+
+    explicit TraceBuffer(int id) : tid(id), events(TRACE_CAPACITY) {}
+
+    // Records an event. Only the owning thread may call this.
+    void record(const char* event, char phase, long long ns) {
+        size_t h = head.load(memory_order_relaxed);
+        events[h & (TRACE_CAPACITY - 1)] = TraceEvent{event, phase, ns};
+        head.store(h + 1, memory_order_release);
+    }
+};
+
+/*
+ * Owner of every buffer. Threads take a buffer on their first event, under a
+ * lock, and give it back when they finish. Written out when destroyed at
+ * exit.
+ */
+class Tracer {
+private:
+    typedef chrono::steady_clock Clock;
+
+    mutex lock;
+    vector<unique_ptr<TraceBuffer>> buffers;
+    vector<TraceBuffer*> free_buffers;
+    Clock::time_point start = Clock::now();
+
+public:
+    string filename = "trace.json";
+
+    // Tracer of the process.
+    static Tracer& instance() {
+        static Tracer tracer;
+        return tracer;
+    }
+
+    // Nanoseconds since the tracer started.
+    long long now() const {
+        return chrono::duration_cast<chrono::nanoseconds>(Clock::now() -
+                                                          start).count();
+    }
+
+    // A buffer for a thread starting to trace.
+    TraceBuffer* take() {
+        lock_guard<mutex> hold(lock);
+        if (!free_buffers.empty()) {
+            TraceBuffer* buffer = free_buffers.back();
+            free_buffers.pop_back();
+            return buffer;
+        }
+        buffers.emplace_back(new TraceBuffer((int)buffers.size()));
+        return buffers.back().get();
+    }
+
+    // Returns the buffer of a finished thread.
+    void give(TraceBuffer* buffer) {
+        lock_guard<mutex> hold(lock);
+        free_buffers.push_back(buffer);
+    }
+
+    // Writes every buffer to filename, oldest events first.
+    ~Tracer() {
+        ofstream out(filename);
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        bool first = true;
+        for (const auto& buffer : buffers) {
+            if (buffer->name) {
+                out << (first ? "" : ",\n") << "{\"name\":\"thread_name\","
+                    << "\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid
+                    << ",\"args\":{\"name\":\"" << buffer->name << "\"}}";
+                first = false;
+            }
+            size_t head = buffer->head.load(memory_order_acquire);
+            size_t oldest = head > TRACE_CAPACITY ? head - TRACE_CAPACITY : 0;
+            for (size_t i = oldest; i < head; i++) {
+                const TraceEvent& e = buffer->events[i & (TRACE_CAPACITY - 1)];
+                out << (first ? "" : ",\n") << "{\"name\":\"" << e.name
+                    << "\",\"ph\":\"" << e.phase << "\",\"ts\":"
+                    << e.ns / 1000 << '.' << e.ns / 100 % 10
+                    << ",\"pid\":1,\"tid\":" << buffer->tid << "}";
+                first = false;
+            }
+        }
+        out << "\n]}\n";
+    }
+};
+
+// Buffer of the calling thread, taken on first use and given back at exit.
+inline TraceBuffer& traceBuffer() {
+    struct Holder {
+        TraceBuffer* buffer = Tracer::instance().take();
+        ~Holder() { Tracer::instance().give(buffer); }
+    };
+    thread_local Holder holder;
+    return *holder.buffer;
+}
+
+// Records an event of the calling thread.
+inline void traceEvent(const char* name, char phase) {
+    traceBuffer().record(name, phase, Tracer::instance().now());
+}
+
+// Traces the scope it is declared in.
+struct TraceScope {
+    const char* name;
+    explicit TraceScope(const char* n) : name(n) { traceEvent(name, 'B'); }
+    ~TraceScope() { traceEvent(name, 'E'); }
+};
+
+#define TRACE_JOIN2(a, b) a##b
+#define TRACE_JOIN(a, b) TRACE_JOIN2(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_JOIN(trace_scope_, __LINE__)(name)
+#define TRACE_BEGIN(name) traceEvent(name, 'B')
+#define TRACE_END(name) traceEvent(name, 'E')
+#define TRACE_THREAD(label) (traceBuffer().name = (label))
+#define TRACE_FILE(file) (Tracer::instance().filename = (file))
+
+#else
+
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_BEGIN(name) ((void)0)
+#define TRACE_END(name) ((void)0)
+#define TRACE_THREAD(label) ((void)0)
+#define TRACE_FILE(file) ((void)0)
+
+#endif  // ACTORGRAPH_TRACE
+
+#endif  // TRACE_HPP
@@ -0,0 +1,503 @@
+/*
+ * This file contains the header only traversal core shared by all searches
+ * over an ActorGraph. A traversal is a label correcting search from one or
+ * more source actors, templated on
+ *
+ *  Frontier      - order in which reached actors are explored. FifoFrontier
+ *                  gives breadth first search, HeapFrontier gives Dijkstra's
+ *                  algorithm, and BucketFrontier gives bucketed Dijkstra for
+ *                  small integer weights.
+ *  WeightPolicy  - weight of traversing a movie. UnitWeight counts hops,
+ *                  MovieWeight uses the weights assigned at load.
+ *  Visitor       - callbacks invoked as the search progresses. Derive from
+ *                  TraversalVisitor and hide only the hooks that are needed.
+ *
+ * All parameters are resolved at compile time, so unused hooks are inlined
+ * away and a specialised traversal compiles to the same loop as a hand
+ * written search. Search state lives in a SearchState owned by the caller, so
+ * independent searches may run over one shared, read only graph.
+ */
+
+#ifndef TRAVERSAL_HPP
+#define TRAVERSAL_HPP
+
+#include <climits>
+#include <cstdint>
+#include <queue>
+#include <vector>
+#include "actorgraph.hpp"
+#include "memory.hpp"
+
+using namespace std;
+
+// Distance of an actor which has not been reached.
+const int UNREACHED = INT_MAX;
+
+/*
+ * Per search labels for every actor and movie of a graph. Only labels touched
+ * by the previous search are cleared on reset, so repeated searches cost time
+ * proportional to the part of the graph they explore.
+ */
+struct SearchState {
+    // Distance from the sources, UNREACHED if not reached.
+    vector<int> dist;
+    // Actor and movie the best known path arrived through, -1 for sources.
+    vector<int> prev_actor;
+    vector<int> prev_movie;
+    // Flags actors which have been settled.
+    vector<char> done;
+    // Distance at which each movie was last expanded, UNREACHED if never.
+    vector<int> movie_dist;
+    // Actors and movies whose labels were modified since the last reset.
+    vector<int> touched;
+    vector<int> touched_movies;
+
+    SearchState() {}
+    explicit SearchState(const ActorGraph& graph) { resize(graph); }
+
+    // Sizes the labels for graph, leaving every actor unreached.
+    void resize(const ActorGraph& graph) {
+        dist.assign(graph.numActors(), UNREACHED);
+        prev_actor.assign(graph.numActors(), -1);
+        prev_movie.assign(graph.numActors(), -1);
+        done.assign(graph.numActors(), 0);
+        movie_dist.assign(graph.numMovies(), UNREACHED);
+        touched.clear();
+        touched_movies.clear();
+    }
+
+    // Returns every label touched by the previous search to unreached.
+    void reset() {
+        for (int v : touched) {
+            dist[v] = UNREACHED;
+            prev_actor[v] = -1;
+            prev_movie[v] = -1;
+            done[v] = 0;
+        }
+        for (int m : touched_movies)
+            movie_dist[m] = UNREACHED;
+        touched.clear();
+        touched_movies.clear();
+    }
+
+    // Labels actor v with distance d through prev / movie.
+    void label(int v, int d, int prev, int movie) {
+        if (dist[v] == UNREACHED)
+            touched.push_back(v);
+        dist[v] = d;
+        prev_actor[v] = prev;
+        prev_movie[v] = movie;
+    }
+};
+
+
+// Traversal weight policies. Return the cost of traversing a movie.
+struct UnitWeight {
+    int operator()(const ActorGraph&, int) const { return 1; }
+};
+
+struct MovieWeight {
+    int operator()(const ActorGraph& graph, int movie) const {
+        return graph.movieWeight(movie);
+    }
+};
+
+
+/*
+ * Visitor with every hook as a no-op. Visitors derive from this class and
+ * hide the hooks they need; all calls are statically dispatched.
+ *
+ *  on_discover(v, d)          - v reached for the first time at distance d.
+ *  on_relax(v, d, from, m)    - v's distance lowered to d through actor from
+ *                               and movie m. Also called on discovery.
+ *  on_settle(v, d)            - v removed from the frontier with final d.
+ *  should_stop(v)             - checked as v leaves the frontier, before it
+ *                               is settled. Returning true ends the search.
+ *  should_expand(v, m)        - returning false skips movie m for actor v.
+ *  should_reach(v)            - returning false leaves actor v unreached.
+ */
+struct TraversalVisitor {
+    void on_discover(int, int) {}
+    void on_relax(int, int, int, int) {}
+    void on_settle(int, int) {}
+    bool should_stop(int) { return false; }
+    bool should_expand(int, int) { return true; }
+    bool should_reach(int) { return true; }
+};
+
+
+// Visitor ending a search once a target actor leaves the frontier.
+struct TargetVisitor : TraversalVisitor {
+    int target;
+    explicit TargetVisitor(int t = -1) : target(t) {}
+    bool should_stop(int v) { return v == target; }
+};
+
+
+/*
+ * Actors and movies a search must not pass through, one bit each, so a
+ * search can avoid them without changing the shared graph.
+ */
+struct Exclusions {
+    vector<uint64_t> actors;
+    vector<uint64_t> movies;
+
+    Exclusions() {}
+    explicit Exclusions(const ActorGraph& graph)
+        : actors((graph.numActors() + 63) / 64, 0),
+          movies((graph.numMovies() + 63) / 64, 0) {}
+
+    void excludeActor(int v) { actors[v >> 6] |= 1ULL << (v & 63); }
+    void excludeMovie(int m) { movies[m >> 6] |= 1ULL << (m & 63); }
+    bool hasActor(int v) const { return actors[v >> 6] >> (v & 63) & 1; }
+    bool hasMovie(int m) const { return movies[m >> 6] >> (m & 63) & 1; }
+    size_t bytes() const { return memoryBytes(actors) + memoryBytes(movies); }
+};
+
+// Visitor adding exclusions to Base: excluded actors are never reached and
+// excluded movies never expanded.
+template <class Base>
+struct AvoidingVisitor : Base {
+    const Exclusions* avoid;
+    explicit AvoidingVisitor(const Exclusions* a, const Base& base = Base())
+        : Base(base), avoid(a) {}
+    bool should_expand(int v, int m) {
+        return !avoid->hasMovie(m) && Base::should_expand(v, m);
+    }
+    bool should_reach(int v) {
+        return !avoid->hasActor(v) && Base::should_reach(v);
+    }
+};
+
+
+// First in first out frontier. Explores actors in breadth first order.
+class FifoFrontier {
+private:
+    vector<int> items;
+    size_t head = 0;
+public:
+    explicit FifoFrontier(const SearchState&) {}
+    bool empty() const { return head == items.size(); }
+    void push(int v) { items.push_back(v); }
+    int pop() { return items[head++]; }
+    void clear() { items.clear(); head = 0; }
+};
+
+
+/*
+ * Orders actors by lower distance first, then by lower previous actor id.
+ * As actor ids follow name order, ties are broken by the previous actor's
+ * name, matching the original ordering of findPath.
+ */
+struct PathOrder {
+    const SearchState* state;
+    bool operator()(int x, int y) const {
+        if (state->dist[x] != state->dist[y])
+            return state->dist[x] > state->dist[y];
+        return state->prev_actor[x] < state->prev_actor[y];
+    }
+};
+
+// Binary heap frontier keyed by the labels in the SearchState.
+template <class Compare = PathOrder>
+class HeapFrontier {
+private:
+    const SearchState* state;
+    priority_queue<int, vector<int>, Compare> pq;
+public:
+    explicit HeapFrontier(const SearchState& s)
+        : state(&s), pq(Compare{&s}) {}
+    bool empty() const { return pq.empty(); }
+    void push(int v) { pq.push(v); }
+    int pop() { int v = pq.top(); pq.pop(); return v; }
+    void clear() { pq = priority_queue<int, vector<int>, Compare>(
+                       Compare{state}); }
+};
+
+
+/*
+ * Bucketed frontier for integer distances. Actors are kept in buckets of
+ * width delta by distance, and the closest actor of the lowest non-empty
+ * bucket is popped first. With delta 1 this is Dial's algorithm, and the
+ * actors of a bucket are all at its distance or settled already, so any may
+ * be popped without a scan; wider buckets mean fewer buckets to walk but a
+ * scan for the closest within each. Exact for non-negative integer weights,
+ * though actors at equal distance pop in no fixed order, so it suits
+ * searches for distances rather than paths with ties broken as findPath.
+ */
+class BucketFrontier {
+private:
+    const SearchState* state;
+    int delta;
+    vector<vector<int>> buckets;
+    size_t current = 0;
+    size_t count = 0;
+public:
+    explicit BucketFrontier(const SearchState& s, int width = 1)
+        : state(&s), delta(width < 1 ? 1 : width) {}
+    bool empty() const { return count == 0; }
+    void push(int v) {
+        size_t b = (size_t)(state->dist[v] / delta);
+        if (b >= buckets.size())
+            buckets.resize(b + 1);
+        if (b < current)
+            current = b;
+        buckets[b].push_back(v);
+        count++;
+    }
+    int pop() {
+        while (buckets[current].empty())
+            current++;
+        vector<int>& bucket = buckets[current];
+        size_t best = bucket.size() - 1;
+        for (size_t i = 0; delta > 1 && i < bucket.size(); i++) {
+            if (state->dist[bucket[i]] < state->dist[bucket[best]])
+                best = i;
+        }
+        int v = bucket[best];
+        bucket[best] = bucket.back();
+        bucket.pop_back();
+        count--;
+        return v;
+    }
+    void clear() {
+        for (vector<int>& bucket : buckets)
+            bucket.clear();
+        current = 0;
+        count = 0;
+    }
+};
+
+
+// Labels v as a source of the next traversal and adds it to the frontier.
+template <class Frontier>
+inline void addSource(SearchState& state, Frontier& frontier, int v) {
+    state.label(v, 0, -1, -1);
+    frontier.push(v);
+}
+
+/*
+ * Work of the previous search in roles scanned: the movies of every actor it
+ * settled and the cast of every movie it expanded. Costs time proportional to
+ * the labels the search touched.
+ */
+inline long long searchWork(const ActorGraph& graph, const SearchState& state) {
+    long long work = 0;
+    for (int v : state.touched) {
+        if (state.done[v])
+            work += graph.moviesOf(v).size();
+    }
+    for (int m : state.touched_movies)
+        work += graph.castOf(m).size();
+    return work;
+}
+
+/*
+ * Settles working as it leaves the frontier, returning false if it was
+ * already settled.
+ */
+template <class Visitor>
+inline bool settle(SearchState& state, Visitor& visitor, int working) {
+    if (state.done[working])
+        return false;
+    state.done[working] = 1;
+    visitor.on_settle(working, state.dist[working]);
+    return true;
+}
+
+/*
+ * Marks movie as expanded by working at working_dist, returning false if the
+ * movie should be skipped: already expanded at this distance or less, or
+ * refused by the visitor.
+ */
+template <class Visitor>
+inline bool claimMovie(SearchState& state, Visitor& visitor, int working,
+                       int working_dist, int movie) {
+    if (state.movie_dist[movie] <= working_dist)
+        return false;
+    if (!visitor.should_expand(working, movie))
+        return false;
+    if (state.movie_dist[movie] == UNREACHED)
+        state.touched_movies.push_back(movie);
+    state.movie_dist[movie] = working_dist;
+    return true;
+}
+
+// Lowers the cast of movie to next_dist through working where that helps.
+template <class Frontier, class Visitor>
+inline void relaxCast(IdRange cast, SearchState& state, Frontier& frontier,
+                      Visitor& visitor, int working, int movie,
+                      int next_dist) {
+    for (int adj_actor : cast) {
+        if (next_dist < state.dist[adj_actor] &&
+            visitor.should_reach(adj_actor)) {
+            bool discovered = state.dist[adj_actor] == UNREACHED;
+            state.label(adj_actor, next_dist, working, movie);
+            if (discovered)
+                visitor.on_discover(adj_actor, next_dist);
+            visitor.on_relax(adj_actor, next_dist, working, movie);
+            frontier.push(adj_actor);
+        }
+    }
+}
+
+/*
+ * Runs a traversal from the sources already in frontier until the frontier is
+ * empty or the visitor stops it.
+ *
+ * A movie reached at distance d relaxes its whole cast to at most d plus its
+ * weight, so the movie is skipped when reached again at a distance of d or
+ * more; such an expansion could not lower any label. This keeps large casts
+ * from being rescanned once per cast member.
+ *
+ * Parameters:
+ *  graph -
+ *      Graph to traverse.
+ *  state -
+ *      Labels of the search, with sources labelled through addSource.
+ *  frontier -
+ *      Frontier holding the sources.
+ *  weight -
+ *      Weight policy applied to each movie.
+ *  visitor -
+ *      Visitor receiving the traversal hooks.
+ *
+ * Returns:
+ *  int -
+ *      The last actor removed from the frontier, or -1 if none was.
+ */
+template <class Frontier, class WeightPolicy, class Visitor>
+inline int traverse(const ActorGraph& graph, SearchState& state,
+                    Frontier& frontier, const WeightPolicy& weight,
+                    Visitor& visitor) {
+    int working = -1;
+    while (!frontier.empty()) {
+        working = frontier.pop();
+
+        if (visitor.should_stop(working))
+            break;
+        if (!settle(state, visitor, working))
+            continue;
+
+        int working_dist = state.dist[working];
+        for (int movie : graph.moviesOf(working)) {
+            if (!claimMovie(state, visitor, working, working_dist, movie))
+                continue;
+            relaxCast(graph.castOf(movie), state, frontier, visitor, working,
+                      movie, working_dist + weight(graph, movie));
+        }
+    }
+    return working;
+}
+
+
+/*
+ * A traversal which runs in small steps, so several searches can be
+ * interleaved on one thread. Each step ends right after prefetching the data
+ * the next step of the search will load, so while that load is in flight the
+ * thread can step other searches. The sequence of labels, hooks and frontier
+ * operations is exactly that of traverse.
+ */
+template <class Frontier, class WeightPolicy, class Visitor>
+class ResumableTraversal {
+private:
+    // Point of the search the next step resumes from
+    enum Phase { POP, MOVIES, NEXT_MOVIE, CAST, RELAX, FINISHED };
+
+    const ActorGraph& graph;
+    SearchState& state;
+    Frontier& frontier;
+    WeightPolicy weight;
+    Visitor& visitor;
+    Phase phase = POP;
+    int working = -1;
+    int working_dist = 0;
+    IdRange movies = IdRange{nullptr, nullptr};
+    const int* next_movie = nullptr;
+    int movie = -1;
+    IdRange cast = IdRange{nullptr, nullptr};
+
+public:
+    // Creates a traversal from the sources already in frontier.
+    ResumableTraversal(const ActorGraph& g, SearchState& s, Frontier& f,
+                       const WeightPolicy& w, Visitor& v)
+        : graph(g), state(s), frontier(f), weight(w), visitor(v) {}
+
+    // Whether the traversal has ended.
+    bool finished() const { return phase == FINISHED; }
+
+    // The last actor removed from the frontier, or -1 if none was.
+    int last() const { return working; }
+
+    /*
+     * Advances the traversal by one step.
+     *
+     * Returns:
+     *  bool -
+     *      False once the traversal has ended.
+     */
+    bool step() {
+        switch (phase) {
+        case POP:
+            if (frontier.empty()) {
+                phase = FINISHED;
+                return false;
+            }
+            working = frontier.pop();
+            if (visitor.should_stop(working)) {
+                phase = FINISHED;
+                return false;
+            }
+            if (!settle(state, visitor, working))
+                return true;
+            working_dist = state.dist[working];
+            movies = graph.moviesOf(working);
+            next_movie = movies.begin();
+            PREFETCH(movies.begin());
+            phase = MOVIES;
+            return true;
+
+        case MOVIES:
+            // Prefetch the labels and cast bounds of every movie
+            for (int m : movies) {
+                PREFETCH(&state.movie_dist[m]);
+                graph.prefetchMovie(m);
+            }
+            phase = NEXT_MOVIE;
+            return true;
+
+        case NEXT_MOVIE:
+            while (next_movie != movies.end()) {
+                movie = *next_movie++;
+                if (!claimMovie(state, visitor, working, working_dist, movie))
+                    continue;
+                cast = graph.castOf(movie);
+                for (const int* a = cast.begin(); a < cast.end(); a += 16)
+                    PREFETCH(a);
+                phase = CAST;
+                return true;
+            }
+            phase = POP;
+            return true;
+
+        case CAST:
+            // Prefetch the labels of the whole cast
+            for (int adj_actor : cast)
+                PREFETCH(&state.dist[adj_actor]);
+            phase = RELAX;
+            return true;
+
+        case RELAX:
+            relaxCast(cast, state, frontier, visitor, working, movie,
+                      working_dist + weight(graph, movie));
+            phase = NEXT_MOVIE;
+            return true;
+
+        case FINISHED:
+            break;
+        }
+        return false;
+    }
+};
+
+#endif  // TRAVERSAL_HPP
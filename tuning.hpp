@@ -0,0 +1,112 @@
+/*
+ * This file contains the tuned parameters of a graph snapshot, which the
+ * analyzer's autotune mode measures on the host and every program reads at
+ * startup. They are kept in a file beside the snapshot, its name plus
+ * ".tune", as a line per parameter of its name and value, tab separated.
+ *
+ * A tuning holds for the snapshot and host it was measured on: the file
+ * records the size of the snapshot and the hardware threads of the host, and
+ * is ignored if either changed. Options given on the command line override
+ * tuned values.
+ */
+
+#ifndef TUNING_HPP
+#define TUNING_HPP
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+class Tuning {
+private:
+    // Name of the tuning file, size of the snapshot in bytes and hardware
+    // threads of the host.
+    string path;
+    long long snapshot_bytes = -1;
+    long long host_threads;
+    // Tuned values by name.
+    map<string, double> values;
+
+public:
+    // Tuning of the named snapshot on this host.
+    explicit Tuning(const string& snapshot)
+        : path(snapshot + ".tune"),
+          host_threads(thread::hardware_concurrency()) {
+        error_code ec;
+        uintmax_t size = filesystem::file_size(snapshot, ec);
+        if (!ec)
+            snapshot_bytes = (long long)size;
+    }
+
+    // Name of the tuning file.
+    const string& file() const { return path; }
+
+    /*
+     * Reads the tuning file, if any, into the values.
+     *
+     * Returns:
+     *  bool -
+     *      True if a tuning of the same snapshot and host was read.
+     */
+    bool load() {
+        values.clear();
+        ifstream in(path);
+        string name;
+        long long bytes = -1, threads = -1;
+        if (!(in >> name >> bytes) || name != "snapshot" ||
+            bytes != snapshot_bytes ||
+            !(in >> name >> threads) || name != "host-threads" ||
+            threads != host_threads)
+            return false;
+        double value;
+        while (in >> name >> value)
+            values[name] = value;
+        return true;
+    }
+
+    /*
+     * Writes the values to the tuning file, through a temporary file renamed
+     * over the previous one.
+     *
+     * Returns:
+     *  bool -
+     *      True if the file was written.
+     */
+    bool save() const {
+        string temp = path + ".tmp";
+        {
+            ofstream out(temp);
+            out << "snapshot\t" << snapshot_bytes << "\nhost-threads\t"
+                << host_threads << "\n";
+            for (const auto& value : values)
+                out << value.first << '\t' << value.second << "\n";
+            if (!out)
+                return false;
+        }
+        return rename(temp.c_str(), path.c_str()) == 0;
+    }
+
+    // Whether the parameter is tuned.
+    bool has(const string& name) const { return values.count(name) > 0; }
+
+    // Tuned value of the parameter, or fallback if not tuned.
+    double get(const string& name, double fallback) const {
+        auto it = values.find(name);
+        return it == values.end() ? fallback : it->second;
+    }
+
+    // Tuned integer value of the parameter, or fallback if not tuned.
+    int getInt(const string& name, int fallback) const {
+        return has(name) ? (int)get(name, 0) : fallback;
+    }
+
+    // Sets the tuned value of the parameter.
+    void set(const string& name, double value) { values[name] = value; }
+};
+
+#endif  // TUNING_HPP